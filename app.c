@@ -1,12 +1,23 @@
 #include "app.h"
 #include "queue.h"
 #include "number_io.h"
+#include "cqueue.h"
+#include "external_sort.h"
+#include "bench.h"
+#include "perf_counters.h"
+#include "simd_sort.h"
+#include "sort_profile.h"
+#include "queue_typed.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <time.h>
 #include <locale.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
 
 #ifdef _WIN32
 #include <direct.h>
@@ -27,15 +38,75 @@ void handle_edit_element(void);
 void handle_queue_operations(void);
 void print_queue_stats(const Queue *q);
 void benchmark_automated(void);
+void benchmark_concurrent(void);
+void benchmark_counting(void);
+void handle_calibrate(void);
+void handle_top_k(void);
+void benchmark_top_k(void);
+int handle_external_sort(int argc, char *argv[]);
+int handle_batch_sort(int argc, char *argv[]);
+int ensure_results_dir(void);
 int safe_scanf_int(int *value);
 int safe_scanf_size_t(size_t *value);
-void save_benchmark_to_csv(const char *filename, size_t *sizes, double *selection_times, 
-                          double *quick_times, double *ratios, int num_sizes, const char *timestamp);
-void print_benchmark_summary(size_t *sizes, double *selection_times, 
-                            double *quick_times, double *ratios, int num_sizes);
+// Память на одном размере теста
+typedef struct BenchMemoryRow {
+    QueueMemStats queue;        // Учет памяти исходной очереди
+    double bytes_per_element;
+    long peak_rss_kb;           // Наибольший пиковый RSS среди замеров
+} BenchMemoryRow;
+
+void save_benchmark_to_csv(const char *filename, size_t *sizes, double *times,
+                          double *ratios, const BenchMemoryRow *memory,
+                          int num_sizes, const char *timestamp);
+void print_benchmark_summary(const char *title, size_t *sizes, double *times,
+                            double *ratios, int num_sizes);
 void print_separator(char ch, int length);
 void print_double_separator(char ch, int length);
 
+// Способ хранения очередей, выбранный ключом --backend
+static QueueBackend app_backend = QUEUE_BACKEND_LIST;
+
+// Прогрев, число замеров и таймаут в сравнении скоростей (ключи --benchmark-auto),
+// аппаратные счетчики (ключ --perf)
+static BenchConfig app_bench_config = {1, 5, 10.0, 60.0, 0};
+
+// Время потоков последнего запуска параллельной сортировки
+static QueueParallelStats last_parallel_stats;
+
+// Параллельная сортировка на всех ядрах (с сохранением времени потоков)
+static void sort_parallel_all_cores(Queue *q)
+{
+    queue_parallel_sort_timed(q, 0, &last_parallel_stats);
+}
+
+// Алгоритм сортировки, доступный в меню и в сравнении скоростей
+typedef struct SortAlgorithm {
+    const char *key;            // Имя для ключа --algo
+    const char *name;           // Название для меню и вывода
+    const char *short_name;     // Заголовок столбца сводной таблицы
+    const char *csv_name;       // Заголовок столбца CSV
+    void (*sort)(Queue *q);
+} SortAlgorithm;
+
+static const SortAlgorithm sort_algorithms[] = {
+    {"auto", "Автовыбор по данным", "Авто (сек)", "Автовыбор (сек)", queue_sort_auto},
+    {"selection", "Метод прямого выбора", "Выбор (сек)", "Сортировка выбором (сек)", queue_selection_sort},
+    {"quick", "Быстрая сортировка (Хоара)", "Быстрая (сек)", "Быстрая сортировка (сек)", queue_quick_sort},
+    {"merge", "Сортировка слиянием", "Слияние (сек)", "Сортировка слиянием (сек)", queue_merge_sort},
+    {"radix", "Поразрядная сортировка", "Поразряд. (сек)", "Поразрядная сортировка (сек)", queue_radix_sort},
+    {"simd", "Векторная сортировка (SIMD)", "SIMD (сек)", "Векторная сортировка (сек)", queue_simd_sort},
+    {"parallel", "Параллельная сортировка", "Паралл. (сек)", "Параллельная сортировка (сек)", sort_parallel_all_cores},
+    {"adaptive", "Адаптивная сортировка (серии)", "Адаптив. (сек)", "Адаптивная сортировка (сек)", queue_adaptive_sort},
+    {"counting", "Сортировка подсчетом", "Подсчет (сек)", "Сортировка подсчетом (сек)", queue_counting_sort},
+};
+#define NUM_SORT_ALGORITHMS (int)(sizeof(sort_algorithms) / sizeof(sort_algorithms[0]))
+#define SORT_AUTO      0        // Алгоритм по умолчанию
+#define SORT_SELECTION 1        // Индексы алгоритмов для отношения выбор/быстрая
+#define SORT_QUICK     2
+
+const SortAlgorithm* choose_sort_algorithm(void);
+void print_parallel_stats(const char *indent);
+
 // Выводит разделительную линию из повторяющихся символов
 void print_separator(char ch, int length) {
     for(int i = 0; i < length; i++) {
@@ -55,6 +126,28 @@ void print_double_separator(char ch, int length) {
 // Основная функция приложения
 int run_app(int argc, char *argv[])
 {
+    // Обработка аргументов командной строки
+    // Выбор хранилища очередей: --backend list|ring|chunked (перед остальными ключами)
+    if (argc >= 3 && strcmp(argv[1], "--backend") == 0) {
+        if (queue_backend_parse(argv[2], &app_backend) != 0) {
+            fprintf(stderr, "Неизвестный способ хранения \"%s\" (допустимо: list, ring, chunked)\n",
+                    argv[2]);
+            return 1;
+        }
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+
+    // Пороги автовыбора сортировки, измеренные --calibrate на этой машине
+    if (sort_profile_load(SORT_PROFILE_FILE) == -2)
+        fprintf(stderr, "Профиль \"%s\" поврежден, используются пороги по умолчанию\n",
+                SORT_PROFILE_FILE);
+
+    // Пакетная сортировка для конвейеров: без настройки локали и лишнего вывода
+    if (argc >= 2 && strcmp(argv[1], "--sort") == 0)
+        return handle_batch_sort(argc, argv);
+
     // Настройка кодировки для корректного отображения русских символов
     #ifdef _WIN32
     SetConsoleOutputCP(65001);
@@ -62,17 +155,67 @@ int run_app(int argc, char *argv[])
     #else
     setlocale(LC_ALL, "Russian");
     #endif
-    
-    // Обработка аргументов командной строки
+
+    // Аппаратные счетчики в сравнении скоростей: --perf (перед режимом)
+    if (argc >= 2 && strcmp(argv[1], "--perf") == 0) {
+        PerfCounters pc;
+        if (perf_counters_open(&pc) == 0)
+            printf("Аппаратные счетчики недоступны (%s), будет замерено только время\n",
+                   perf_counters_error());
+        else if (pc.opened < PERF_COUNTER_COUNT)
+            printf("Часть аппаратных счетчиков недоступна (%s)\n", perf_counters_error());
+        perf_counters_close(&pc);
+        app_bench_config.perf_counters = 1;
+        argv[1] = argv[0];
+        argv++;
+        argc--;
+    }
+
     if (argc == 3 && strcmp(argv[1], "--file") == 0) {
         handle_file_mode(argv[2]);
         return 0;
     }
     
-    if (argc == 2 && strcmp(argv[1], "--benchmark-auto") == 0) {
+    // --benchmark-auto [замеров [прогревов [таймаут_сек]]]
+    if (argc >= 2 && argc <= 5 && strcmp(argv[1], "--benchmark-auto") == 0) {
+        if (argc >= 3)
+            app_bench_config.repetitions = atoi(argv[2]);
+        if (argc >= 4)
+            app_bench_config.warmup = atoi(argv[3]);
+        if (argc == 5)
+            app_bench_config.timeout = atof(argv[4]);
+        if (app_bench_config.repetitions < 1 || app_bench_config.repetitions > BENCH_MAX_SAMPLES ||
+            app_bench_config.warmup < 0 || app_bench_config.timeout < 0) {
+            printf("Число замеров - от 1 до %d, прогревов и таймаут - не меньше 0\n",
+                   BENCH_MAX_SAMPLES);
+            return 1;
+        }
         benchmark_automated();
         return 0;
     }
+    
+    if (argc == 2 && strcmp(argv[1], "--benchmark-cqueue") == 0) {
+        benchmark_concurrent();
+        return 0;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "--benchmark-counting") == 0) {
+        benchmark_counting();
+        return 0;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "--benchmark-topk") == 0) {
+        benchmark_top_k();
+        return 0;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "--calibrate") == 0) {
+        handle_calibrate();
+        return 0;
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "--external-sort") == 0)
+        return handle_external_sort(argc, argv);
 
     printf("Программа для работы с очередью и сортировкой\n");
     print_separator('=', 45);
@@ -80,11 +223,12 @@ int run_app(int argc, char *argv[])
     int done = 0;
     while (!done) {
         printf("\nМеню:\n");
-        printf("1 - Создать очередь и отсортировать (метод прямого выбора)\n");
+        printf("1 - Создать очередь и отсортировать\n");
         printf("2 - Сравнение скоростей сортировок (очередь)\n");
         printf("3 - Редактировать элемент очереди\n");
         printf("4 - Основные операции с очередью\n");
         printf("5 - Работа с файлом\n");
+        printf("6 - k наименьших и наибольших элементов\n");
         printf("0 - Выход\n> ");
 
         int choice;
@@ -110,6 +254,9 @@ int run_app(int argc, char *argv[])
         case 4:
             handle_queue_operations();
             break;
+        case 6:
+            handle_top_k();
+            break;
         case 5:
             {
                 char filename[256];
@@ -174,36 +321,423 @@ int safe_scanf_size_t(size_t *value)
 }
 
 // Режим работы с файлом: загрузка, обработка, сохранение
+// Файл отображается в память, каждая строка разбирается только перед печатью
 void handle_file_mode(const char *filename)
 {
-    int *prev_orig = NULL, *prev_sorted = NULL;
-    size_t prev_orig_n = 0, prev_sorted_n = 0;
+    RowFile rf;
+    int *prev_orig = NULL;
+    size_t prev_orig_n = 0;
 
-    // Загрузка ранее сохраненных данных
-    if (load_previous_rows(filename, &prev_orig, &prev_orig_n,
-                          &prev_sorted, &prev_sorted_n) == 0 &&
-        prev_orig && prev_orig_n > 0) {
-        
+    // Загрузка ранее сохраненных данных (текстовых или двоичных)
+    int status = row_file_open(&rf, filename);
+    if (status == -2) {
+        printf("Файл \"%s\" поврежден.\n", filename);
+        return;
+    }
+    if (status != 0) {
+        printf("Файл \"%s\" не найден или пуст.\n", filename);
+        return;
+    }
+
+    prev_orig_n = row_file_read(&rf, 0, &prev_orig, NULL);
+    if (prev_orig && prev_orig_n > 0) {
         printf("Предыдущий введенный ряд: ");
         print_int_array(prev_orig, prev_orig_n);
+        free(prev_orig);
 
+        int *prev_sorted = NULL;
+        size_t prev_sorted_n = row_file_read(&rf, 1, &prev_sorted, NULL);
         if (prev_sorted && prev_sorted_n > 0) {
             printf("Предыдущий отсортированный ряд: ");
             print_int_array(prev_sorted, prev_sorted_n);
         }
+        free(prev_sorted);
     } else {
+        free(prev_orig);
         printf("Файл \"%s\" не найден или пуст.\n", filename);
     }
 
-    free(prev_orig);
-    free(prev_sorted);
-    
-    return;
+    if (rf.corrupt)
+        printf("Файл \"%s\" поврежден: не сошлась контрольная сумма.\n", filename);
+
+    row_file_close(&rf);
+}
+
+// Внешняя сортировка файла: --external-sort <вход> <выход> [память_МБ]
+int handle_external_sort(int argc, char *argv[])
+{
+    if (argc < 4 || argc > 5) {
+        printf("Использование: %s --external-sort <входной файл> <выходной файл> [память, МБ]\n",
+               argv[0]);
+        return 1;
+    }
+
+    size_t memory_mb = EXTERNAL_DEFAULT_MEMORY_MB;
+    if (argc == 5) {
+        char *end;
+        unsigned long value = strtoul(argv[4], &end, 10);
+        if (*end != '\0' || value == 0) {
+            printf("Неверный объем памяти \"%s\"\n", argv[4]);
+            return 1;
+        }
+        memory_mb = (size_t)value;
+    }
+
+    printf("Внешняя сортировка \"%s\" -> \"%s\", память: %zu МБ\n",
+           argv[2], argv[3], memory_mb);
+
+    ExternalSortStats stats;
+    int status = external_sort_file(argv[2], argv[3], memory_mb * 1024 * 1024, 1, &stats);
+    switch (status) {
+    case 0:
+        break;
+    case EXTERNAL_ERR_INPUT:
+        printf("Ошибка чтения файла \"%s\".\n", argv[2]);
+        return 1;
+    case EXTERNAL_ERR_OUTPUT:
+        printf("Ошибка записи файла \"%s\".\n", argv[3]);
+        return 1;
+    default:
+        printf("Ошибка: не хватает памяти или места для временных файлов.\n");
+        return 1;
+    }
+
+    printf("Отсортировано чисел: %zu, серий: %zu, проходов слияния: %d, время: %.3f сек\n",
+           stats.values, stats.runs, stats.merge_passes, stats.seconds);
+    if (stats.parse.overflow > 0 || stats.parse.invalid > 0)
+        printf("Пропущено: вне диапазона int - %zu, нечисловых - %zu\n",
+               stats.parse.overflow, stats.parse.invalid);
+    return 0;
+}
+
+// Подсказка по ключам пакетной сортировки (в stderr, чтобы не смешивать с результатом)
+static void print_batch_sort_usage(const char *program)
+{
+    fprintf(stderr, "Использование: %s [--backend list|ring|chunked] --sort "
+                    "[--type int|int64|double] [--algo ", program);
+    for (int a = 0; a < NUM_SORT_ALGORITHMS; a++)
+        fprintf(stderr, "%s%s", sort_algorithms[a].key, a + 1 < NUM_SORT_ALGORITHMS ? "|" : "");
+    fprintf(stderr, "] [--top k | --top-largest k] [--in файл|-] [--out файл|-]\n");
+    fprintf(stderr, "Для int64 и double: --algo auto|quick|merge, хранилище - список\n");
+    fprintf(stderr, "--top: только k наименьших по возрастанию (--top-largest - наибольших\n"
+                    "по убыванию) без полной сортировки; только для int\n");
+}
+
+/* ==================== ПАКЕТНАЯ СОРТИРОВКА INT64 И DOUBLE ==================== */
+
+QUEUE_DEFINE(QueueI64, long long, QUEUE_LESS)
+QUEUE_DEFINE(QueueF64, double, QUEUE_LESS)
+
+// Чтение лексемы (до пробельного символа) в buf размера size
+// 0 - прочитана, 1 - не поместилась (остаток пропущен), -1 - конец входа
+static int read_token(FILE *in, char *buf, size_t size)
+{
+    int c;
+    while ((c = getc(in)) != EOF && isspace(c)) {}
+    if (c == EOF)
+        return -1;
+
+    size_t len = 0;
+    int truncated = 0;
+    for (; c != EOF && !isspace(c); c = getc(in)) {
+        if (len + 1 < size)
+            buf[len++] = (char)c;
+        else
+            truncated = 1;
+    }
+    buf[len] = 0;
+    return truncated;
+}
+
+// Разбор лексемы: 0 - число, -1 - не число, -2 - вне диапазона типа
+static int parse_i64(const char *token, long long *value)
+{
+    char *end;
+    errno = 0;
+    *value = strtoll(token, &end, 10);
+    if (end == token || *end != 0)
+        return -1;
+    return errno == ERANGE ? -2 : 0;
+}
+
+// NaN не упорядочен оператором <, поэтому считается не числом
+static int parse_f64(const char *token, double *value)
+{
+    char *end;
+    errno = 0;
+    *value = strtod(token, &end);
+    if (end == token || *end != 0 || *value != *value)
+        return -1;
+    return errno == ERANGE && (*value > 1 || *value < -1) ? -2 : 0;
+}
+
+static int write_i64(FILE *out, long long value)
+{
+    return fprintf(out, "%lld", value);
+}
+
+// 17 значащих цифр: значение читается обратно без потерь
+static int write_f64(FILE *out, double value)
+{
+    return fprintf(out, "%.17g", value);
+}
+
+// Пакетная сортировка типизированной очереди name: чтение лексем из in,
+// сортировка (merge - устойчивая слиянием, иначе быстрая через массив)
+// и запись одной строкой в out_path; коды возврата как у handle_batch_sort
+#define DEFINE_BATCH_SORT(name, type, parse, write)                            \
+static int name##_batch_sort(FILE *in, const char *in_path, const char *algo,  \
+                             const char *out_path)                             \
+{                                                                              \
+    name q;                                                                    \
+    name##_init(&q);                                                           \
+    size_t overflow = 0, invalid = 0;                                          \
+    char token[128];                                                           \
+    int r;                                                                     \
+    while ((r = read_token(in, token, sizeof(token))) >= 0) {                  \
+        type value;                                                            \
+        int parsed = r == 0 ? parse(token, &value) : -1;                       \
+        if (parsed == -2) {                                                    \
+            overflow++;                                                        \
+        } else if (parsed != 0) {                                              \
+            invalid++;                                                         \
+        } else if (name##_push(&q, value) != 0) {                              \
+            fprintf(stderr, "Не хватает памяти\n");                            \
+            name##_free(&q);                                                   \
+            return 1;                                                          \
+        }                                                                      \
+    }                                                                          \
+    if (ferror(in)) {                                                          \
+        fprintf(stderr, "Ошибка чтения \"%s\"\n", in_path);                    \
+        name##_free(&q);                                                       \
+        return 1;                                                              \
+    }                                                                          \
+    if (overflow > 0 || invalid > 0)                                           \
+        fprintf(stderr, "Пропущено: вне диапазона - %zu, нечисловых - %zu\n",  \
+                overflow, invalid);                                            \
+                                                                               \
+    if (strcmp(algo, "merge") == 0)                                            \
+        name##_merge_sort(&q);                                                 \
+    else                                                                       \
+        name##_quick_sort(&q);                                                 \
+                                                                               \
+    FILE *out = strcmp(out_path, "-") == 0 ? stdout : fopen(out_path, "wb");   \
+    if (!out) {                                                                \
+        fprintf(stderr, "Не удалось создать \"%s\": %s\n", out_path,          \
+                strerror(errno));                                              \
+        name##_free(&q);                                                       \
+        return 1;                                                              \
+    }                                                                          \
+    int status = 0;                                                            \
+    for (name##Node *node = q.head; node && status == 0; node = node->next) {  \
+        if (node != q.head && fputc(' ', out) == EOF)                          \
+            status = -1;                                                       \
+        if (write(out, node->value) < 0)                                       \
+            status = -1;                                                       \
+    }                                                                          \
+    if (q.size > 0 && fputc('\n', out) == EOF)                                 \
+        status = -1;                                                           \
+    if (out != stdout) {                                                       \
+        if (fclose(out) != 0)                                                  \
+            status = -1;                                                       \
+    } else if (fflush(stdout) != 0) {                                          \
+        status = -1;                                                           \
+    }                                                                          \
+    name##_free(&q);                                                           \
+                                                                               \
+    if (status != 0) {                                                         \
+        fprintf(stderr, "Ошибка записи \"%s\"\n", out_path);                   \
+        return 1;                                                              \
+    }                                                                          \
+    return 0;                                                                  \
+}
+
+DEFINE_BATCH_SORT(QueueI64, long long, parse_i64, write_i64)
+DEFINE_BATCH_SORT(QueueF64, double, parse_f64, write_f64)
+
+// Пакетная сортировка int64 или double (type) через типизированные очереди
+static int batch_sort_typed(const char *type, const char *algo,
+                            const char *in_path, const char *out_path)
+{
+    if (strcmp(algo, "auto") != 0 && strcmp(algo, "quick") != 0 &&
+        strcmp(algo, "merge") != 0) {
+        fprintf(stderr, "Алгоритм \"%s\" недоступен для --type %s\n", algo, type);
+        return 2;
+    }
+
+    FILE *in = strcmp(in_path, "-") == 0 ? stdin : fopen(in_path, "rb");
+    if (!in) {
+        fprintf(stderr, "Не удалось открыть \"%s\": %s\n", in_path, strerror(errno));
+        return 1;
+    }
+    int status = strcmp(type, "int64") == 0
+                 ? QueueI64_batch_sort(in, in_path, algo, out_path)
+                 : QueueF64_batch_sort(in, in_path, algo, out_path);
+    if (in != stdin)
+        fclose(in);
+    return status;
+}
+
+// Пакетная сортировка: все числа входа (любое число строк) проходят через
+// очередь и выводятся одной строкой. В stdout не пишется ничего, кроме
+// результата; ошибки и пропущенные лексемы - в stderr.
+// Выходной файл открывается после чтения, поэтому --in и --out могут совпадать
+int handle_batch_sort(int argc, char *argv[])
+{
+    const char *algo = "auto", *type = "int", *in_path = "-", *out_path = "-";
+    size_t top_k = 0;           // 0 - полная сортировка
+    int top_largest = 0;
+    for (int i = 2; i < argc; i += 2) {
+        if (i + 1 >= argc) {
+            print_batch_sort_usage(argv[0]);
+            return 2;
+        }
+        if (strcmp(argv[i], "--algo") == 0) {
+            algo = argv[i + 1];
+        } else if (strcmp(argv[i], "--type") == 0) {
+            type = argv[i + 1];
+        } else if (strcmp(argv[i], "--top") == 0 || strcmp(argv[i], "--top-largest") == 0) {
+            char *end;
+            unsigned long long k = strtoull(argv[i + 1], &end, 10);
+            if (argv[i + 1][0] == '-' || end == argv[i + 1] || *end != 0 || k == 0) {
+                fprintf(stderr, "k должно быть положительным числом: \"%s\"\n", argv[i + 1]);
+                return 2;
+            }
+            top_k = (size_t)k;
+            top_largest = strcmp(argv[i], "--top-largest") == 0;
+        } else if (strcmp(argv[i], "--in") == 0) {
+            in_path = argv[i + 1];
+        } else if (strcmp(argv[i], "--out") == 0) {
+            out_path = argv[i + 1];
+        } else {
+            fprintf(stderr, "Неизвестный ключ \"%s\"\n", argv[i]);
+            print_batch_sort_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (top_k > 0 && strcmp(type, "int") != 0) {
+        fprintf(stderr, "--top доступен только для --type int\n");
+        return 2;
+    }
+    if (strcmp(type, "int64") == 0 || strcmp(type, "double") == 0)
+        return batch_sort_typed(type, algo, in_path, out_path);
+    if (strcmp(type, "int") != 0) {
+        fprintf(stderr, "Неизвестный тип \"%s\"\n", type);
+        print_batch_sort_usage(argv[0]);
+        return 2;
+    }
+
+    void (*sort)(Queue *q) = NULL;
+    for (int a = 0; a < NUM_SORT_ALGORITHMS; a++) {
+        if (strcmp(algo, sort_algorithms[a].key) == 0)
+            sort = sort_algorithms[a].sort;
+    }
+    if (!sort) {
+        fprintf(stderr, "Неизвестный алгоритм \"%s\"\n", algo);
+        print_batch_sort_usage(argv[0]);
+        return 2;
+    }
+
+    FILE *in = strcmp(in_path, "-") == 0 ? stdin : fopen(in_path, "rb");
+    if (!in) {
+        fprintf(stderr, "Не удалось открыть \"%s\": %s\n", in_path, strerror(errno));
+        return 1;
+    }
+
+    Queue q;
+    queue_init_backend(&q, app_backend);
+    NumberParseStats stats;
+    int status = read_ints_stream_to_queue(in, &q, &stats);
+    if (in != stdin)
+        fclose(in);
+    if (status != 0) {
+        fprintf(stderr, "Ошибка чтения \"%s\" или нехватка памяти\n", in_path);
+        queue_free(&q);
+        return 1;
+    }
+    if (stats.overflow > 0 || stats.invalid > 0)
+        fprintf(stderr, "Пропущено: вне диапазона int - %zu, нечисловых - %zu\n",
+                stats.overflow, stats.invalid);
+
+    if (top_k > 0) {
+        // Очередь заменяется найденными k значениями
+        if (top_k > q.size)
+            top_k = q.size;
+        int *top = (int *)malloc((top_k ? top_k : 1) * sizeof(int));
+        if (!top) {
+            fprintf(stderr, "Не хватает памяти\n");
+            queue_free(&q);
+            return 1;
+        }
+        if (top_largest)
+            queue_top_k_largest(&q, top_k, top);
+        else
+            queue_top_k(&q, top_k, top);
+        queue_free(&q);
+        queue_init_backend(&q, app_backend);
+        status = queue_push_n(&q, top, top_k);
+        free(top);
+        if (status != 0) {
+            fprintf(stderr, "Не хватает памяти\n");
+            queue_free(&q);
+            return 1;
+        }
+    } else {
+        sort(&q);
+    }
+
+    FILE *out = strcmp(out_path, "-") == 0 ? stdout : fopen(out_path, "wb");
+    if (!out) {
+        fprintf(stderr, "Не удалось создать \"%s\": %s\n", out_path, strerror(errno));
+        queue_free(&q);
+        return 1;
+    }
+    status = queue_write(&q, out);
+    if (out != stdout) {
+        if (fclose(out) != 0)
+            status = -1;
+    } else if (fflush(stdout) != 0) {
+        status = -1;
+    }
+    queue_free(&q);
+
+    if (status != 0) {
+        fprintf(stderr, "Ошибка записи \"%s\"\n", out_path);
+        return 1;
+    }
+    return 0;
+}
+
+// Выбор алгоритма сортировки; пустой ввод - автовыбор
+const SortAlgorithm* choose_sort_algorithm(void)
+{
+    printf("Алгоритм сортировки (Enter - автовыбор):\n");
+    for (int a = 0; a < NUM_SORT_ALGORITHMS; a++)
+        printf("%d - %s\n", a + 1, sort_algorithms[a].name);
+    printf("> ");
+
+    char line[32];
+    if (fgets(line, sizeof(line), stdin) == NULL)
+        return NULL;
+    if (line[0] == '\n')
+        return &sort_algorithms[SORT_AUTO];
+
+    int choice = atoi(line);
+    if (choice < 1 || choice > NUM_SORT_ALGORITHMS)
+        return NULL;
+    return &sort_algorithms[choice - 1];
 }
 
 // Однократная сортировка очереди
 void handle_sort_once(void)
 {
+    const SortAlgorithm *algorithm = choose_sort_algorithm();
+    if (!algorithm) {
+        printf("Неизвестный алгоритм.\n");
+        return;
+    }
+
     char filename[256];
     printf("Введите имя файла для сохранения: ");
     if (fgets(filename, sizeof(filename), stdin) == NULL) {
@@ -218,42 +752,33 @@ void handle_sort_once(void)
     }
 
     Queue q;
-    queue_init(&q);
+    queue_init_backend(&q, app_backend);
 
     printf("Введите последовательность целых чисел через пробел:\n> ");
-    int *numbers = NULL;
-    size_t count = read_ints_from_stdin(&numbers);
-    
-    if (count == 0 || !numbers) {
+    if (read_queue_from_stdin(&q) == 0) {
         printf("Не удалось прочитать числа.\n");
         queue_free(&q);
-        free(numbers);
         return;
     }
 
-    for (size_t i = 0; i < count; ++i) {
-        if (queue_push(&q, numbers[i]) != 0) {
-            printf("Ошибка: не хватает памяти.\n");
-            free(numbers);
-            queue_free(&q);
-            return;
-        }
-    }
-
     printf("\nИсходная очередь:\n");
     queue_print(&q);
 
     Queue *q_copy = queue_copy(&q);
     if (!q_copy) {
         printf("Ошибка копирования очереди.\n");
-        free(numbers);
         queue_free(&q);
         return;
     }
 
-    queue_selection_sort(q_copy);
+    // Уже упорядоченные данные не сортируются вовсе
+    if (queue_is_sorted(q_copy)) {
+        printf("Очередь уже упорядочена, сортировка не нужна.\n");
+    } else {
+        algorithm->sort(q_copy);
+    }
 
-    printf("Отсортированная очередь:\n");
+    printf("Отсортированная очередь (%s):\n", algorithm->name);
     queue_print(q_copy);
 
     // Сохраняем в файл
@@ -261,16 +786,8 @@ void handle_sort_once(void)
     int *sorted_array = (int*)malloc(q.size * sizeof(int));
     
     if (orig_array && sorted_array) {
-        QueueNode *node_sorted = q_copy->head;
-        QueueNode *node_orig = q.head;
-        size_t i = 0;
-        while (node_sorted) {
-            orig_array[i] = node_orig->value;
-            sorted_array[i] = node_sorted->value; // уже отсортировано
-            node_sorted = node_sorted->next;
-            node_orig = node_orig->next;
-            i++;
-        }
+        queue_to_array(&q, orig_array);
+        queue_to_array(q_copy, sorted_array); // уже отсортировано
         
         if (save_rows(filename, orig_array, q.size, sorted_array, q.size) == 0) {
             printf("Данные сохранены в файл \"%s\".\n", filename);
@@ -279,10 +796,10 @@ void handle_sort_once(void)
         }
     }
     
+    queue_free(q_copy);
     free(q_copy);
     free(orig_array);
     free(sorted_array);
-    free(numbers);
     queue_free(&q);
 }
 
@@ -290,28 +807,16 @@ void handle_sort_once(void)
 void handle_edit_element(void)
 {
     Queue q;
-    queue_init(&q);
+    queue_init_backend(&q, app_backend);
+    queue_enable_index(&q, 0);
 
     printf("Введите последовательность целых чисел через пробел:\n> ");
-    int *numbers = NULL;
-    size_t count = read_ints_from_stdin(&numbers);
-    
-    if (count == 0 || !numbers) {
+    if (read_queue_from_stdin(&q) == 0) {
         printf("Не удалось прочитать числа.\n");
         queue_free(&q);
-        free(numbers);
         return;
     }
 
-    for (size_t i = 0; i < count; ++i) {
-        if (queue_push(&q, numbers[i]) != 0) {
-            printf("Ошибка: не хватает памяти для очереди.\n");
-            free(numbers);
-            queue_free(&q);
-            return;
-        }
-    }
-
     printf("\nТекущая очередь (%zu элементов):\n", q.size);
     queue_print(&q);
 
@@ -322,7 +827,6 @@ void handle_edit_element(void)
         printf("Введите индекс элемента для редактирования (0-%zu): ", q.size - 1);
         if (!safe_scanf_size_t(&index)) {
             printf("Ошибка ввода индекса.\n");
-            free(numbers);
             queue_free(&q);
             return;
         }
@@ -330,7 +834,6 @@ void handle_edit_element(void)
         printf("Введите новое значение: ");
         if (!safe_scanf_int(&new_value)) {
             printf("Ошибка ввода значения.\n");
-            free(numbers);
             queue_free(&q);
             return;
         }
@@ -343,7 +846,6 @@ void handle_edit_element(void)
         }
     }
 
-    free(numbers);
     queue_free(&q);
 }
 
@@ -351,7 +853,8 @@ void handle_edit_element(void)
 void handle_queue_operations(void)
 {
     Queue q;
-    queue_init(&q);
+    queue_init_backend(&q, app_backend);
+    queue_enable_index(&q, 0);
     
     int done = 0;
     while (!done) {
@@ -362,6 +865,7 @@ void handle_queue_operations(void)
         printf("4 - Редактировать элемент\n");
         printf("5 - Очистить очередь\n");
         printf("6 - Вывести статистику\n");
+        printf("7 - Получить элемент по индексу\n");
         printf("0 - Назад\n> ");
         
         int choice;
@@ -427,12 +931,33 @@ void handle_queue_operations(void)
         }
         case 5:
             queue_free(&q);
-            queue_init(&q);
+            queue_init_backend(&q, app_backend);
+            queue_enable_index(&q, 0);
             printf("Очередь очищена.\n");
             break;
         case 6:
             print_queue_stats(&q);
             break;
+        case 7: {
+            if (q.size == 0) {
+                printf("Очередь пуста.\n");
+                break;
+            }
+            size_t index;
+            int value;
+            printf("Введите индекс (0-%zu): ", q.size - 1);
+            if (!safe_scanf_size_t(&index)) {
+                printf("Ошибка ввода индекса.\n");
+                break;
+            }
+            getchar();
+            if (queue_get_at(&q, index, &value) == 0) {
+                printf("Элемент [%zu] = %d\n", index, value);
+            } else {
+                printf("Неверный индекс.\n");
+            }
+            break;
+        }
         case 0:
             done = 1;
             break;
@@ -450,19 +975,29 @@ void print_queue_stats(const Queue *q)
 {
     printf("\nСтатистика очереди:\n");
     printf("Количество элементов: %zu\n", q->size);
+    printf("Хранилище: %s\n", queue_backend_name(q->backend));
     printf("Состояние: %s\n", queue_is_empty(q) ? "пуста" : "не пуста");
+    printf("Память хранилища: %zu байт (пик %zu), %.1f байт на элемент\n",
+           q->mem.bytes_live, q->mem.bytes_peak, queue_bytes_per_element(q));
+    printf("Выделений памяти: %zu, освобождений: %zu\n", q->mem.allocs, q->mem.frees);
     
     if (!queue_is_empty(q)) {
-        printf("Первый элемент: %d\n", q->head->value);
-        printf("Последний элемент: %d\n", q->tail->value);
+        int front, back;
+        queue_front(q, &front);
+        queue_back(q, &back);
+        printf("Первый элемент: %d\n", front);
+        printf("Последний элемент: %d\n", back);
         printf("Содержимое: ");
         queue_print(q);
     }
 }
 
 // Сохранение результатов бенчмарка в CSV файл
-void save_benchmark_to_csv(const char *filename, size_t *sizes, double *selection_times, 
-                          double *quick_times, double *ratios, int num_sizes, const char *timestamp)
+// times[i * NUM_SORT_ALGORITHMS + a] - время алгоритма a на размере sizes[i],
+// memory[i] - память очереди и процесса на этом размере
+void save_benchmark_to_csv(const char *filename, size_t *sizes, double *times,
+                          double *ratios, const BenchMemoryRow *memory,
+                          int num_sizes, const char *timestamp)
 {
     FILE *f = fopen(filename, "w");
     if (!f) {
@@ -471,15 +1006,26 @@ void save_benchmark_to_csv(const char *filename, size_t *sizes, double *selectio
     }
     
     // Заголовок CSV (разделитель - точка с запятой для Excel)
-    fprintf(f, "Размер очереди;Сортировка выбором (сек);Быстрая сортировка (сек);Отношение (выбор/быстрая);Дата теста\n");
+    fprintf(f, "Размер очереди");
+    for (int a = 0; a < NUM_SORT_ALGORITHMS; a++)
+        fprintf(f, ";%s", sort_algorithms[a].csv_name);
+    fprintf(f, ";Отношение (выбор/быстрая);Память очереди (байт);Байт на элемент;"
+               "Выделений памяти;Пик памяти очереди (байт);Пиковый RSS (КБ);Дата теста\n");
     
     // Запись данных
     for (int i = 0; i < num_sizes; i++) {
-        fprintf(f, "%zu;%.6f;%.6f;%.2f;%s\n",
-                sizes[i],
-                selection_times[i],
-                quick_times[i],
-                ratios[i],
+        fprintf(f, "%zu", sizes[i]);
+        for (int a = 0; a < NUM_SORT_ALGORITHMS; a++) {
+            // Пустая ячейка - замер снят по таймауту или не удался
+            double t = times[i * NUM_SORT_ALGORITHMS + a];
+            if (t >= 0)
+                fprintf(f, ";%.6f", t);
+            else
+                fprintf(f, ";");
+        }
+        const BenchMemoryRow *m = &memory[i];
+        fprintf(f, ";%.2f;%zu;%.2f;%zu;%zu;%ld;%s\n", ratios[i], m->queue.bytes_live,
+                m->bytes_per_element, m->queue.allocs, m->queue.bytes_peak, m->peak_rss_kb,
                 timestamp);
     }
     
@@ -487,22 +1033,47 @@ void save_benchmark_to_csv(const char *filename, size_t *sizes, double *selectio
     printf("Результаты сохранены в CSV файл: %s\n", filename);
 }
 
+// Надпись, дополненная пробелами до width символов
+// (выравнивание по символам, а не по байтам UTF-8)
+static void print_label_cell(const char *label, int width)
+{
+    int chars = 0;
+    for (const char *c = label; *c; c++)
+        chars += ((unsigned char)*c & 0xC0) != 0x80;
+    printf("%s%*s", label, chars < width ? width - chars : 0, "");
+}
+
+// Ячейка таблицы с временем или причиной, по которой его нет
+static void print_time_cell(double t)
+{
+    if (t >= 0) {
+        printf(" | %-14.6f", t);
+        return;
+    }
+    printf(" | ");
+    print_label_cell(t == BENCH_TIMEOUT ? "таймаут" : t == BENCH_CRASHED ? "сбой" : "ошибка", 14);
+}
+
 // Вывод сводки результатов тестирования
-void print_benchmark_summary(size_t *sizes, double *selection_times, 
-                            double *quick_times, double *ratios, int num_sizes)
+void print_benchmark_summary(const char *title, size_t *sizes, double *times,
+                            double *ratios, int num_sizes)
 {
     print_double_separator('=', 60);
-    printf("РЕЗУЛЬТАТЫ ТЕСТИРОВАНИЯ\n");
+    printf("РЕЗУЛЬТАТЫ ТЕСТИРОВАНИЯ: %s\n", title);
     print_separator('=', 60);
     printf("\n");
     
-    printf("%-12s | %-20s | %-20s | %-15s\n", 
-           "Размер", "Выбор (сек)", "Быстрая (сек)", "Отношение");
-    print_separator('-', 73);
+    printf("%-12s", "Размер");
+    for (int a = 0; a < NUM_SORT_ALGORITHMS; a++)
+        printf(" | %-14s", sort_algorithms[a].short_name);
+    printf(" | %-15s\n", "Отношение");
+    print_separator('-', 12 + 17 * NUM_SORT_ALGORITHMS + 18);
     
     for (int i = 0; i < num_sizes; i++) {
-        printf("%-12zu | %-20.6f | %-20.6f | %-15.2f\n", 
-               sizes[i], selection_times[i], quick_times[i], ratios[i]);
+        printf("%-12zu", sizes[i]);
+        for (int a = 0; a < NUM_SORT_ALGORITHMS; a++)
+            print_time_cell(times[i * NUM_SORT_ALGORITHMS + a]);
+        printf(" | %-15.2f\n", ratios[i]);
     }
     
     // Подсчет статистики
@@ -530,6 +1101,132 @@ void print_benchmark_summary(size_t *sizes, double *selection_times,
     }
 }
 
+// Вывод времени потоков последней параллельной сортировки
+void print_parallel_stats(const char *indent)
+{
+    const QueueParallelStats *st = &last_parallel_stats;
+    printf("%sПотоков: %d, всего %.6f сек\n", indent, st->threads, st->total_seconds);
+    for (int i = 0; i < st->threads; i++) {
+        printf("%s  поток %2d: сортировка %.6f, разрезание %.6f, слияние %.6f сек\n",
+               indent, i, st->sort_seconds[i], st->cut_seconds[i], st->merge_seconds[i]);
+    }
+}
+
+// Заполнение очереди n числами заданного распределения
+// Числа генерируются в массив и добавляются одним вызовом queue_push_n
+static int fill_queue(Queue *q, size_t n, BenchDistribution dist)
+{
+    int *values = (int *)malloc(n * sizeof(int));
+    if (!values)
+        return -1;
+    bench_fill(values, n, dist);
+
+    int result = queue_push_n(q, values, n);
+    free(values);
+    return result;
+}
+
+// Замер сортировки: каждый запуск получает свежую копию исходной очереди
+typedef struct SortBenchContext {
+    const Queue *src;
+    Queue *copy;
+    void (*sort)(Queue *q);
+} SortBenchContext;
+
+static int sort_bench_prepare(void *ctx)
+{
+    SortBenchContext *c = (SortBenchContext *)ctx;
+    c->copy = queue_copy(c->src);
+    return c->copy ? 0 : -1;
+}
+
+static void sort_bench_run(void *ctx)
+{
+    SortBenchContext *c = (SortBenchContext *)ctx;
+    c->sort(c->copy);
+}
+
+static void sort_bench_cleanup(void *ctx)
+{
+    SortBenchContext *c = (SortBenchContext *)ctx;
+    queue_free(c->copy);
+    free(c->copy);
+    c->copy = NULL;
+}
+
+// Замеры сортировки на копиях очереди (копирование не входит во время)
+// Возвращает медиану в секундах или отрицательный код BENCH_*
+static double time_sort_on_copy(const BenchConfig *config, const Queue *src,
+                                void (*sort)(Queue *q), BenchStats *stats)
+{
+    SortBenchContext ctx = {src, NULL, sort};
+    BenchTask task = {sort_bench_prepare, sort_bench_run, sort_bench_cleanup, &ctx};
+    int status = bench_measure(config, &task, stats);
+    if (status != BENCH_OK)
+        return status;
+    return stats->median;
+}
+
+// Строка статистики замеров (или причина, по которой их нет)
+// и, если снимались, счетчики процессора на один элемент из n
+static void print_bench_stats(int status, const BenchStats *st, size_t n)
+{
+    if (status == BENCH_TIMEOUT)
+        printf("таймаут %.0f сек, процесс остановлен (замеров %d)\n",
+               app_bench_config.timeout, st->samples);
+    else if (status == BENCH_CRASHED)
+        printf("аварийное завершение процесса (замеров %d)\n", st->samples);
+    else if (status != BENCH_OK)
+        printf("ошибка: не хватает памяти\n");
+    else
+        printf("медиана %.6f сек (мин %.6f, p95 %.6f, откл. %.6f, замеров %d)\n",
+               st->median, st->min, st->p95, st->stddev, st->samples);
+
+    if (!app_bench_config.perf_counters || status != BENCH_OK || n == 0)
+        return;
+    int any = 0;
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++)
+        any |= st->counters[c] >= 0;
+    if (!any)
+        return;             // Об этом уже сказано при запуске
+    printf("      на элемент:");
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+        if (st->counters[c] >= 0)
+            printf(" %s %.2f", perf_counter_name((PerfCounterId)c), st->counters[c] / (double)n);
+    }
+    if (st->counters[PERF_CYCLES] > 0 && st->counters[PERF_INSTRUCTIONS] >= 0)
+        printf(", IPC %.2f", st->counters[PERF_INSTRUCTIONS] / st->counters[PERF_CYCLES]);
+    printf("\n");
+}
+
+// Память исходной очереди и наибольший пиковый RSS среди замеров
+static void fill_memory_row(BenchMemoryRow *row, const Queue *q,
+                            const BenchStats *stats, int count)
+{
+    row->queue = q->mem;
+    row->bytes_per_element = queue_bytes_per_element(q);
+    row->peak_rss_kb = 0;
+    for (int a = 0; a < count; a++) {
+        if (stats[a].peak_rss_kb > row->peak_rss_kb)
+            row->peak_rss_kb = stats[a].peak_rss_kb;
+    }
+}
+
+static void print_memory_row(const char *indent, const BenchMemoryRow *row)
+{
+    printf("%sПамять очереди: %zu байт (%.1f байт на элемент, выделений %zu), "
+           "пиковый RSS %ld КБ\n", indent, row->queue.bytes_live, row->bytes_per_element,
+           row->queue.allocs, row->peak_rss_kb);
+}
+
+// Описание машины и настроек программы для файлов с результатами
+static void fill_bench_machine(BenchMachine *machine)
+{
+    bench_machine_info(machine);
+    snprintf(machine->setup, sizeof(machine->setup), "backend=%s sort_kernel=%s",
+             queue_backend_name(app_backend), simd_sort_kernel_name());
+}
+
 // Интерактивное тестирование скорости сортировок
 void handle_benchmark(void)
 {
@@ -541,41 +1238,57 @@ void handle_benchmark(void)
     }
     getchar();
 
-    Queue q1, q2;
-    queue_init(&q1);
-    queue_init(&q2);
+    Queue q;
+    queue_init_backend(&q, app_backend);
 
     printf("Генерируем %zu случайных чисел...\n", n);
     srand((unsigned)time(NULL));
-    for (size_t i = 0; i < n; ++i) {
-        int val = rand() % 1000000;
-        queue_push(&q1, val);
-        queue_push(&q2, val);
-    }
-
-    // Тестирование сортировки выбором
-    printf("Тестирование сортировки выбором...\n");
-    clock_t start = clock();
-    queue_selection_sort(&q1);
-    clock_t end = clock();
-    double t_selection = (double)(end - start) / CLOCKS_PER_SEC;
-
-    // Тестирование быстрой сортировки
-    printf("Тестирование быстрой сортировки...\n");
-    start = clock();
-    queue_quick_sort(&q2);
-    end = clock();
-    double t_quick = (double)(end - start) / CLOCKS_PER_SEC;
-
-    printf("\nРезультаты для очереди из %zu элементов:\n", n);
-    printf("Метод прямого выбора: %.6f сек.\n", t_selection);
-    printf("Быстрая сортировка (Хоара): %.6f сек.\n", t_quick);
-    
-    if (t_quick > 0) {
+    if (fill_queue(&q, n, BENCH_DIST_RANDOM) != 0) {
+        printf("Ошибка: не хватает памяти.\n");
+        queue_free(&q);
+        return;
+    }
+
+    // Замеры в этом же процессе, чтобы было видно время потоков
+    BenchConfig config = app_bench_config;
+    config.timeout = 0;
+
+    double times[NUM_SORT_ALGORITHMS];
+    BenchStats stats[NUM_SORT_ALGORITHMS];
+    for (int a = 0; a < NUM_SORT_ALGORITHMS; a++) {
+        printf("Тестирование: %s...\n", sort_algorithms[a].name);
+        times[a] = time_sort_on_copy(&config, &q, sort_algorithms[a].sort, &stats[a]);
+        if (sort_algorithms[a].sort == sort_parallel_all_cores)
+            print_parallel_stats("  ");
+    }
+
+    // Потоки параллельной сортировки при многих повторах: равные значения
+    // должны расходиться по диапазонам, иначе слияние идет в одном потоке
+    Queue few;
+    queue_init_backend(&few, app_backend);
+    if (fill_queue(&few, n, BENCH_DIST_FEW_UNIQUE) == 0) {
+        BenchStats few_stats;
+        printf("Параллельная сортировка, %s:\n",
+               bench_distribution_name(BENCH_DIST_FEW_UNIQUE));
+        if (time_sort_on_copy(&config, &few, sort_parallel_all_cores, &few_stats) >= 0)
+            print_parallel_stats("  ");
+    }
+    queue_free(&few);
+
+    printf("\nРезультаты для очереди из %zu элементов (прогрев %d, замеров до %d):\n",
+           n, app_bench_config.warmup, app_bench_config.repetitions);
+    for (int a = 0; a < NUM_SORT_ALGORITHMS; a++) {
+        printf("%s: ", sort_algorithms[a].name);
+        print_bench_stats(times[a] < 0 ? (int)times[a] : BENCH_OK, &stats[a], n);
+    }
+    
+    double t_selection = times[SORT_SELECTION];
+    double t_quick = times[SORT_QUICK];
+    if (t_quick > 0 && t_selection >= 0) {
         double ratio = t_selection / t_quick;
         printf("Отношение скоростей: %.2f:1 (быстрая быстрее в %.2f раз)\n", ratio, ratio);
     } else {
-        printf("Отношение скоростей: N/A (время быстрой сортировки равно 0)\n");
+        printf("Отношение скоростей: N/A (нет времени одной из сортировок)\n");
     }
 
     // Сохранение результатов в CSV файл
@@ -594,46 +1307,55 @@ void handle_benchmark(void)
         if (csv_filename[i] == ' ') csv_filename[i] = '_';
     }
     
+    BenchMemoryRow memory;
+    fill_memory_row(&memory, &q, stats, NUM_SORT_ALGORITHMS);
+    print_memory_row("", &memory);
+
     // Подготовка данных для сохранения
     size_t sizes_single[] = {n};
-    double selection_single[] = {t_selection};
-    double quick_single[] = {t_quick};
-    double ratio_single = (t_quick > 0) ? t_selection / t_quick : 0;
+    double ratio_single = (t_quick > 0 && t_selection >= 0) ? t_selection / t_quick : 0;
     double ratios_single[] = {ratio_single};
     
-    save_benchmark_to_csv(csv_filename, sizes_single, selection_single, 
-                         quick_single, ratios_single, 1, timestamp);
+    save_benchmark_to_csv(csv_filename, sizes_single, times, ratios_single, &memory, 1,
+                          timestamp);
     
     printf("\nФайл CSV создан: %s\n", csv_filename);
     printf("Откройте его в Excel для построения графиков.\n");
 
-    queue_free(&q1);
-    queue_free(&q2);
+    queue_free(&q);
 }
 
-// Автоматическое тестирование на нескольких размерах
-void benchmark_automated(void)
+// Создание папки benchmark_results (0 - папка есть или создана)
+int ensure_results_dir(void)
 {
-    printf("Автоматическое тестирование алгоритмов сортировки\n");
-    print_separator('=', 48);
-    printf("\n");
-    
-    // Создание папки для результатов
     #ifdef _WIN32
     if (_mkdir("benchmark_results") != 0) {
         if (errno != EEXIST) {
             printf("Ошибка создания папки benchmark_results\n");
-            return;
+            return -1;
         }
     }
     #else
     if (mkdir("benchmark_results", 0755) != 0) {
         if (errno != EEXIST) {
             printf("Ошибка создания папки benchmark_results\n");
-            return;
+            return -1;
         }
     }
     #endif
+    return 0;
+}
+
+// Автоматическое тестирование на нескольких размерах и распределениях данных
+void benchmark_automated(void)
+{
+    printf("Автоматическое тестирование алгоритмов сортировки\n");
+    print_separator('=', 48);
+    printf("\n");
+    
+    // Создание папки для результатов
+    if (ensure_results_dir() != 0)
+        return;
     
     // Формирование временной метки
     char timestamp[64];
@@ -644,103 +1366,890 @@ void benchmark_automated(void)
     // Размеры для тестирования
     size_t sizes[] = {100, 500, 1000, 5000, 10000, 20000, 50000, 75000, 100000};
     int num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+    int per_dist = num_sizes * NUM_SORT_ALGORITHMS;
     
-    double *selection_times = (double*)malloc(num_sizes * sizeof(double));
-    double *quick_times = (double*)malloc(num_sizes * sizeof(double));
-    double *ratios = (double*)malloc(num_sizes * sizeof(double));
+    // times[d * per_dist + i * NUM_SORT_ALGORITHMS + a], ratios[d * num_sizes + i]
+    double *times = (double*)malloc(BENCH_DIST_COUNT * per_dist * sizeof(double));
+    double *ratios = (double*)malloc(BENCH_DIST_COUNT * num_sizes * sizeof(double));
+    BenchResult *results = (BenchResult*)calloc(BENCH_DIST_COUNT * per_dist, sizeof(BenchResult));
+    BenchMemoryRow *memory = (BenchMemoryRow*)calloc(BENCH_DIST_COUNT * num_sizes,
+                                                     sizeof(BenchMemoryRow));
     
-    if (!selection_times || !quick_times || !ratios) {
+    if (!times || !ratios || !results || !memory) {
         printf("Ошибка выделения памяти для результатов\n");
-        free(selection_times);
-        free(quick_times);
+        free(times);
         free(ratios);
+        free(results);
+        free(memory);
         return;
     }
     
-    printf("Запуск тестов для %d различных размеров...\n\n", num_sizes);
+    printf("Запуск тестов для %d распределений и %d размеров "
+           "(прогрев %d, замеров до %d, таймаут %.0f сек)...\n\n",
+           BENCH_DIST_COUNT, num_sizes, app_bench_config.warmup,
+           app_bench_config.repetitions, app_bench_config.timeout);
     
-    // Цикл тестирования для каждого размера
-    for (int i = 0; i < num_sizes; i++) {
-        size_t n = sizes[i];
-        printf("Тест %d/%d: размер = %zu\n", i+1, num_sizes, n);
-        
-        Queue q1, q2;
-        queue_init(&q1);
-        queue_init(&q2);
+    for (int d = 0; d < BENCH_DIST_COUNT; d++) {
+        const char *dist_name = bench_distribution_name((BenchDistribution)d);
+        print_separator('-', 48);
+        printf("Распределение %d/%d: %s\n", d + 1, BENCH_DIST_COUNT, dist_name);
         
-        srand((unsigned)time(NULL) + i);
-        printf("   Генерация %zu случайных чисел... \n", n);
-        
-        for (size_t j = 0; j < n; ++j) {
-            int val = rand() % 1000000;
-            queue_push(&q1, val);
-            queue_push(&q2, val);
+        // Цикл тестирования для каждого размера
+        for (int i = 0; i < num_sizes; i++) {
+            size_t n = sizes[i];
+            double *row = &times[d * per_dist + i * NUM_SORT_ALGORITHMS];
+            BenchResult *res_row = &results[d * per_dist + i * NUM_SORT_ALGORITHMS];
+            printf("Тест %d/%d: размер = %zu\n", i+1, num_sizes, n);
+            
+            Queue q;
+            queue_init_backend(&q, app_backend);
+            
+            srand((unsigned)time(NULL) + i);
+            printf("   Генерация %zu чисел (%s)... \n", n, dist_name);
+            
+            if (fill_queue(&q, n, (BenchDistribution)d) != 0) {
+                printf("   Ошибка: не хватает памяти.\n");
+                queue_free(&q);
+                for (int a = 0; a < NUM_SORT_ALGORITHMS; a++) {
+                    row[a] = BENCH_ERROR;
+                    res_row[a].name = sort_algorithms[a].name;
+                    res_row[a].distribution = dist_name;
+                    res_row[a].size = n;
+                    res_row[a].status = BENCH_ERROR;
+                }
+                ratios[d * num_sizes + i] = 0;
+                continue;
+            }
+            
+            // Каждый алгоритм сортирует свою копию одних и тех же данных
+            BenchStats row_stats[NUM_SORT_ALGORITHMS];
+            for (int a = 0; a < NUM_SORT_ALGORITHMS; a++) {
+                BenchResult *res = &res_row[a];
+                printf("   %s... ", sort_algorithms[a].name);
+                fflush(stdout);
+                double elapsed = time_sort_on_copy(&app_bench_config, &q,
+                                                   sort_algorithms[a].sort, &res->stats);
+                res->name = sort_algorithms[a].name;
+                res->distribution = dist_name;
+                res->size = n;
+                res->status = elapsed < 0 ? (int)elapsed : BENCH_OK;
+                
+                print_bench_stats(res->status, &res->stats, n);
+                row[a] = elapsed;
+                row_stats[a] = res->stats;
+            }
+            
+            BenchMemoryRow *mem_row = &memory[d * num_sizes + i];
+            fill_memory_row(mem_row, &q, row_stats, NUM_SORT_ALGORITHMS);
+            print_memory_row("   ", mem_row);
+            
+            double t_selection = row[SORT_SELECTION];
+            double t_quick = row[SORT_QUICK];
+            double *ratio = &ratios[d * num_sizes + i];
+            if (t_quick > 0 && t_selection >= 0) {
+                *ratio = t_selection / t_quick;
+            } else {
+                *ratio = 0.0;
+            }
+            
+            printf("   Отношение: %.2f:1\n\n", *ratio);
+            
+            queue_free(&q);
         }
-        
-        // Сортировка выбором
-        printf("   Сортировка выбором... ");
-        fflush(stdout);
-        clock_t start = clock();
-        queue_selection_sort(&q1);
-        clock_t end = clock();
-        double t_selection = (double)(end - start) / CLOCKS_PER_SEC;
-        
-        if (t_selection < 0.000001) t_selection = 0.000001;
-        printf("%.6f сек\n", t_selection);
-        
-        // Быстрая сортировка
-        printf("   Быстрая сортировка... ");
-        fflush(stdout);
-        start = clock();
-        queue_quick_sort(&q2);
-        end = clock();
-        double t_quick = (double)(end - start) / CLOCKS_PER_SEC;
-        
-        if (t_quick < 0.000001) t_quick = 0.000001;
-        printf("%.6f сек\n", t_quick);
-        
-        selection_times[i] = t_selection;
-        quick_times[i] = t_quick;
-        
-        if (t_quick > 0.000001) {
-            ratios[i] = t_selection / t_quick;
-        } else {
-            ratios[i] = 0.0;
-        }
-        
-        printf("   Отношение: %.2f:1\n\n", ratios[i]);
-        
-        queue_free(&q1);
-        queue_free(&q2);
     }
     
-    // Сохранение результатов в CSV
-    char csv_filename[256];
-    snprintf(csv_filename, sizeof(csv_filename), 
-             "benchmark_results/benchmark_comprehensive_%s.csv", timestamp);
+    // Сохранение результатов в CSV: по файлу на распределение
+    char csv_base[256];
+    snprintf(csv_base, sizeof(csv_base), 
+             "benchmark_results/benchmark_comprehensive_%s", timestamp);
     
     // Заменяем недопустимые символы в имени файла
-    for (int i = 0; csv_filename[i]; i++) {
-        if (csv_filename[i] == ':') csv_filename[i] = '-';
-        if (csv_filename[i] == ' ') csv_filename[i] = '_';
+    for (int i = 0; csv_base[i]; i++) {
+        if (csv_base[i] == ':') csv_base[i] = '-';
+        if (csv_base[i] == ' ') csv_base[i] = '_';
     }
     
-    save_benchmark_to_csv(csv_filename, sizes, selection_times, 
-                         quick_times, ratios, num_sizes, timestamp);
+    char csv_filename[300];
+    for (int d = 0; d < BENCH_DIST_COUNT; d++) {
+        snprintf(csv_filename, sizeof(csv_filename), "%s_%s.csv",
+                 csv_base, bench_distribution_name((BenchDistribution)d));
+        save_benchmark_to_csv(csv_filename, sizes, &times[d * per_dist],
+                              &ratios[d * num_sizes], &memory[d * num_sizes],
+                              num_sizes, timestamp);
+    }
+
+    // Подробная статистика замеров: CSV и JSON со сведениями о машине
+    BenchMachine machine;
+    fill_bench_machine(&machine);
+    char stats_filename[300];
+    snprintf(stats_filename, sizeof(stats_filename), "%s_stats.csv", csv_base);
+    if (bench_save_csv(stats_filename, results, BENCH_DIST_COUNT * per_dist,
+                       &machine, &app_bench_config) == 0)
+        printf("Статистика замеров сохранена в CSV файл: %s\n", stats_filename);
+    snprintf(stats_filename, sizeof(stats_filename), "%s_stats.json", csv_base);
+    if (bench_save_json(stats_filename, results, BENCH_DIST_COUNT * per_dist,
+                        &machine, &app_bench_config) == 0)
+        printf("Статистика замеров сохранена в JSON файл: %s\n", stats_filename);
     
-    // Вывод сводки результатов
-    print_benchmark_summary(sizes, selection_times, quick_times, ratios, num_sizes);
+    // Вывод сводки результатов: по таблице на распределение
+    for (int d = 0; d < BENCH_DIST_COUNT; d++)
+        print_benchmark_summary(bench_distribution_name((BenchDistribution)d), sizes,
+                                &times[d * per_dist], &ratios[d * num_sizes], num_sizes);
     
-    free(selection_times);
-    free(quick_times);
+    free(times);
     free(ratios);
+    free(results);
+    free(memory);
     
     printf("\nТестирование завершено!\n");
-    printf("Данные сохранены в CSV файл: '%s'\n", csv_filename);
+    printf("Данные сохранены в CSV файлы: '%s_<распределение>.csv'\n", csv_base);
     printf("\nИнструкция для Excel:\n");
     printf("1. Откройте файл в Excel\n");
     printf("2. Выделите все данные\n");
     printf("3. Вставьте -> Диаграмма -> Точечная диаграмма\n");
     printf("4. Настройте оси (X - Размер очереди, Y - Время в секундах)\n");
     printf("5. Добавьте линию тренда для каждого алгоритма\n");
-}
\ No newline at end of file
+}
+
+/* ==================== ПОРОГ СОРТИРОВКИ ПОДСЧЕТОМ ==================== */
+
+// Соперники сортировки подсчетом при узком диапазоне значений
+static const SortAlgorithm counting_rivals[] = {
+    {"counting", "Подсчет", "Подсчет", "Сортировка подсчетом (сек)", queue_counting_sort},
+    {"radix", "Поразрядная", "Поразряд.", "Поразрядная сортировка (сек)", queue_radix_sort},
+    {"simd", "Векторная", "SIMD", "Векторная сортировка (сек)", queue_simd_sort},
+    {"auto", "Автовыбор", "Авто", "Автовыбор (сек)", queue_sort_auto},
+};
+#define NUM_COUNTING_RIVALS (int)(sizeof(counting_rivals) / sizeof(counting_rivals[0]))
+
+// Ширина диапазона в долях размера: range = n * COUNTING_RATIOS[k] / 64
+static const size_t counting_ratios[] = {1, 4, 16, 32, 64, 128, 256, 512, 1024, 4096};
+#define NUM_COUNTING_RATIOS (int)(sizeof(counting_ratios) / sizeof(counting_ratios[0]))
+
+// Случайные числа из [0, range)
+static void fill_range(int *values, size_t n, size_t range)
+{
+    for (size_t j = 0; j < n; j++)
+        values[j] = (int)((((size_t)rand() << 15) ^ (size_t)rand()) % range);
+}
+
+// Сравнение сортировки подсчетом с поразрядной и векторной на случайных
+// числах из [0, диапазон) при растущем отношении диапазон/размер:
+// для каждого размера ищется наибольшее отношение, при котором подсчет
+// еще быстрее остальных. Это порог counting_ratio из QueueSortThresholds
+// (sort_tuning.list/.array в queue.c, --calibrate пишет его в профиль)
+void benchmark_counting(void)
+{
+    printf("Порог сортировки подсчетом (хранилище %s)\n", queue_backend_name(app_backend));
+    print_separator('=', 48);
+
+    if (ensure_results_dir() != 0)
+        return;
+
+    char timestamp[64];
+    time_t now = time(NULL);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
+
+    char csv_filename[256];
+    snprintf(csv_filename, sizeof(csv_filename),
+             "benchmark_results/benchmark_counting_%s.csv", timestamp);
+    for (int i = 0; csv_filename[i]; i++) {
+        if (csv_filename[i] == ':') csv_filename[i] = '-';
+        if (csv_filename[i] == ' ') csv_filename[i] = '_';
+    }
+    FILE *csv = fopen(csv_filename, "w");
+    if (csv) {
+        fprintf(csv, "Размер;Диапазон;Диапазон/размер");
+        for (int a = 0; a < NUM_COUNTING_RIVALS; a++)
+            fprintf(csv, ";%s", counting_rivals[a].csv_name);
+        fprintf(csv, ";Дата теста\n");
+    }
+
+    size_t sizes[] = {1 << 16, 1 << 20};
+    int num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+
+    for (int i = 0; i < num_sizes; i++) {
+        size_t n = sizes[i];
+        int *values = (int *)malloc(n * sizeof(int));
+        if (!values) {
+            printf("Ошибка выделения памяти\n");
+            break;
+        }
+
+        printf("\nРазмер %zu\n", n);
+        print_label_cell("Диап./n", 10);
+        printf(" | ");
+        print_label_cell("Диапазон", 10);
+        for (int a = 0; a < NUM_COUNTING_RIVALS; a++) {
+            printf(" | ");
+            print_label_cell(counting_rivals[a].short_name, 14);
+        }
+        printf("\n");
+        print_separator('-', 23 + 17 * NUM_COUNTING_RIVALS);
+
+        double crossover = 0;       // Наибольшее отношение, где подсчет быстрее всех
+        for (int k = 0; k < NUM_COUNTING_RATIOS; k++) {
+            size_t range = n * counting_ratios[k] / 64;
+            if (range > QUEUE_COUNTING_MAX_RANGE)
+                break;
+            double ratio = counting_ratios[k] / 64.0;
+
+            srand((unsigned)time(NULL) + k);
+            fill_range(values, n, range);
+
+            Queue q;
+            queue_init_backend(&q, app_backend);
+            if (queue_push_n(&q, values, n) != 0) {
+                printf("Ошибка выделения памяти\n");
+                queue_free(&q);
+                break;
+            }
+
+            double times[NUM_COUNTING_RIVALS];
+            BenchStats stats;
+            printf("%-10g | %-10zu", ratio, range);
+            for (int a = 0; a < NUM_COUNTING_RIVALS; a++) {
+                times[a] = time_sort_on_copy(&app_bench_config, &q, counting_rivals[a].sort, &stats);
+                print_time_cell(times[a]);
+                fflush(stdout);
+            }
+            printf("\n");
+            queue_free(&q);
+
+            // Автовыбор не соперник, а проверка порога
+            int counting_wins = times[0] >= 0;
+            for (int a = 1; a < NUM_COUNTING_RIVALS - 1; a++) {
+                if (times[a] >= 0 && times[a] <= times[0])
+                    counting_wins = 0;
+            }
+            if (counting_wins)
+                crossover = ratio;
+
+            if (csv) {
+                fprintf(csv, "%zu;%zu;%g", n, range, ratio);
+                for (int a = 0; a < NUM_COUNTING_RIVALS; a++) {
+                    if (times[a] >= 0)
+                        fprintf(csv, ";%.6f", times[a]);
+                    else
+                        fprintf(csv, ";");
+                }
+                fprintf(csv, ";%s\n", timestamp);
+            }
+        }
+        free(values);
+
+        if (crossover > 0)
+            printf("Подсчет быстрее остальных до диапазона %g * размер\n", crossover);
+        else
+            printf("Подсчет не быстрее остальных ни при одном диапазоне\n");
+    }
+
+    if (csv) {
+        fclose(csv);
+        printf("\nРезультаты сохранены в CSV файл: %s\n", csv_filename);
+    }
+}
+
+/* ==================== K НАИМЕНЬШИХ ==================== */
+
+// k наименьших и наибольших элементов и частичная сортировка очереди
+void handle_top_k(void)
+{
+    Queue q;
+    queue_init_backend(&q, app_backend);
+
+    printf("Введите последовательность целых чисел через пробел:\n> ");
+    if (read_queue_from_stdin(&q) == 0) {
+        printf("Не удалось прочитать числа.\n");
+        queue_free(&q);
+        return;
+    }
+
+    size_t k;
+    printf("Введите k: ");
+    if (!safe_scanf_size_t(&k) || k == 0) {
+        printf("Некорректное k.\n");
+        queue_free(&q);
+        return;
+    }
+    getchar();
+    if (k > q.size)
+        k = q.size;
+
+    int *top = (int *)malloc(k * sizeof(int));
+    if (!top) {
+        printf("Ошибка выделения памяти\n");
+        queue_free(&q);
+        return;
+    }
+    queue_top_k(&q, k, top);
+    printf("%zu наименьших: ", k);
+    print_int_array(top, k);
+    queue_top_k_largest(&q, k, top);
+    printf("%zu наибольших: ", k);
+    print_int_array(top, k);
+    free(top);
+
+    queue_partial_sort(&q, k);
+    printf("После частичной сортировки (первые %zu упорядочены):\n", k);
+    queue_print(&q);
+    queue_free(&q);
+}
+
+// Замер поиска k наименьших: k и буфер результата задаются перед замером
+static size_t top_k_bench_k;
+static int *top_k_bench_out;
+
+static void top_k_bench_heap(Queue *q)
+{
+    queue_top_k(q, top_k_bench_k, top_k_bench_out);
+}
+
+static void top_k_bench_partial(Queue *q)
+{
+    queue_partial_sort(q, top_k_bench_k);
+}
+
+static const SortAlgorithm top_k_rivals[] = {
+    {"top", "Куча на k", "Куча на k", "queue_top_k (сек)", top_k_bench_heap},
+    {"partial", "Частичная", "Частичная", "queue_partial_sort (сек)", top_k_bench_partial},
+    {"auto", "Полная: автовыбор", "Авто", "Полная сортировка, автовыбор (сек)", queue_sort_auto},
+    {"quick", "Полная: быстрая", "Быстрая", "Полная быстрая сортировка (сек)", queue_quick_sort},
+};
+#define NUM_TOP_K_RIVALS (int)(sizeof(top_k_rivals) / sizeof(top_k_rivals[0]))
+#define TOP_K_FULL_FIRST 2      // С этого индекса - полные сортировки
+
+// k наименьших из n случайных чисел: куча и частичная сортировка
+// против полной сортировки при k от 1 до n / 10
+void benchmark_top_k(void)
+{
+    size_t n = 1000000;
+    printf("k наименьших без полной сортировки (хранилище %s, n = %zu)\n",
+           queue_backend_name(app_backend), n);
+    print_separator('=', 48);
+
+    if (ensure_results_dir() != 0)
+        return;
+
+    Queue q;
+    queue_init_backend(&q, app_backend);
+    srand((unsigned)time(NULL));
+    top_k_bench_out = (int *)malloc(n * sizeof(int));
+    if (!top_k_bench_out || fill_queue(&q, n, BENCH_DIST_RANDOM) != 0) {
+        printf("Ошибка выделения памяти\n");
+        free(top_k_bench_out);
+        queue_free(&q);
+        return;
+    }
+
+    char timestamp[64];
+    time_t now = time(NULL);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
+
+    char csv_filename[256];
+    snprintf(csv_filename, sizeof(csv_filename),
+             "benchmark_results/benchmark_topk_%s.csv", timestamp);
+    for (int i = 0; csv_filename[i]; i++) {
+        if (csv_filename[i] == ':') csv_filename[i] = '-';
+        if (csv_filename[i] == ' ') csv_filename[i] = '_';
+    }
+    FILE *csv = fopen(csv_filename, "w");
+    if (csv) {
+        fprintf(csv, "Размер;k");
+        for (int a = 0; a < NUM_TOP_K_RIVALS; a++)
+            fprintf(csv, ";%s", top_k_rivals[a].csv_name);
+        fprintf(csv, ";Дата теста\n");
+    }
+
+    printf("\n");
+    print_label_cell("k", 10);
+    for (int a = 0; a < NUM_TOP_K_RIVALS; a++) {
+        printf(" | ");
+        print_label_cell(top_k_rivals[a].short_name, 14);
+    }
+    printf(" | Выигрыш\n");
+    print_separator('-', 10 + 17 * NUM_TOP_K_RIVALS + 10);
+
+    // Полные сортировки от k не зависят - замеряются один раз
+    double full[NUM_TOP_K_RIVALS];
+    BenchStats stats;
+    for (int a = TOP_K_FULL_FIRST; a < NUM_TOP_K_RIVALS; a++)
+        full[a] = time_sort_on_copy(&app_bench_config, &q, top_k_rivals[a].sort, &stats);
+
+    for (size_t k = 1; k <= n / 10; k *= 10) {
+        top_k_bench_k = k;
+        double times[NUM_TOP_K_RIVALS];
+        printf("%-10zu", k);
+        for (int a = 0; a < NUM_TOP_K_RIVALS; a++) {
+            times[a] = a < TOP_K_FULL_FIRST
+                       ? time_sort_on_copy(&app_bench_config, &q, top_k_rivals[a].sort, &stats)
+                       : full[a];
+            print_time_cell(times[a]);
+            fflush(stdout);
+        }
+
+        // Во сколько раз лучший частичный способ быстрее лучшей полной сортировки
+        double best_partial = -1, best_full = -1;
+        for (int a = 0; a < NUM_TOP_K_RIVALS; a++) {
+            double *best = a < TOP_K_FULL_FIRST ? &best_partial : &best_full;
+            if (times[a] >= 0 && (*best < 0 || times[a] < *best))
+                *best = times[a];
+        }
+        if (best_partial > 0 && best_full >= 0)
+            printf(" | %.1fx\n", best_full / best_partial);
+        else
+            printf(" | -\n");
+
+        if (csv) {
+            fprintf(csv, "%zu;%zu", n, k);
+            for (int a = 0; a < NUM_TOP_K_RIVALS; a++) {
+                if (times[a] >= 0)
+                    fprintf(csv, ";%.6f", times[a]);
+                else
+                    fprintf(csv, ";");
+            }
+            fprintf(csv, ";%s\n", timestamp);
+        }
+    }
+
+    free(top_k_bench_out);
+    top_k_bench_out = NULL;
+    queue_free(&q);
+    if (csv) {
+        fclose(csv);
+        printf("\nРезультаты сохранены в CSV файл: %s\n", csv_filename);
+    }
+}
+
+/* ==================== КАЛИБРОВКА АВТОВЫБОРА ==================== */
+
+#define CALIBRATE_MAX_SMALL    4096       // Предел поиска порога маленьких очередей
+#define CALIBRATE_RUNS_SIZE    (1 << 17)  // Размер очереди при поиске порога серий
+#define CALIBRATE_BATCH        (1 << 14)  // Элементов во всех копиях одного замера
+#define CALIBRATE_MAX_COPIES   1024
+#define CALIBRATE_COUNTING_SIZE (1 << 18) // Размер очереди при поиске порога подсчета
+#define CALIBRATE_MIN_PARALLEL (1 << 14)  // Границы поиска порога параллельной сортировки
+#define CALIBRATE_MAX_PARALLEL (1 << 21)
+
+// Замеры калибровки короче, чем в сравнении скоростей, и без отдельного процесса
+static const BenchConfig calibrate_config = {1, 5, 2.0, 0, 0};
+
+// Замер калибровки: за один запуск сортируются count копий очереди,
+// чтобы время маленьких очередей было много больше погрешности часов
+typedef struct CalibrateContext {
+    const Queue *src;
+    Queue *copies[CALIBRATE_MAX_COPIES];
+    int count;
+    void (*sort)(Queue *q);
+} CalibrateContext;
+
+static void calibrate_cleanup(void *ctx)
+{
+    CalibrateContext *c = (CalibrateContext *)ctx;
+    for (int i = 0; i < c->count && c->copies[i]; i++) {
+        queue_free(c->copies[i]);
+        free(c->copies[i]);
+        c->copies[i] = NULL;
+    }
+}
+
+static int calibrate_prepare(void *ctx)
+{
+    CalibrateContext *c = (CalibrateContext *)ctx;
+    memset(c->copies, 0, sizeof(c->copies));
+    for (int i = 0; i < c->count; i++) {
+        c->copies[i] = queue_copy(c->src);
+        if (!c->copies[i]) {
+            calibrate_cleanup(ctx);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void calibrate_run(void *ctx)
+{
+    CalibrateContext *c = (CalibrateContext *)ctx;
+    for (int i = 0; i < c->count; i++)
+        c->sort(c->copies[i]);
+}
+
+// Не медленнее ли сортировка a сортировки b на n значениях values
+static int calibrate_wins(QueueBackend backend, const int *values, size_t n,
+                          void (*a)(Queue *q), void (*b)(Queue *q))
+{
+    Queue q;
+    queue_init_backend(&q, backend);
+    if (queue_push_n(&q, values, n) != 0) {
+        queue_free(&q);
+        return 0;
+    }
+
+    CalibrateContext ctx;
+    ctx.src = &q;
+    ctx.count = n >= CALIBRATE_BATCH ? 1 : (int)(CALIBRATE_BATCH / n);
+    if (ctx.count > CALIBRATE_MAX_COPIES)
+        ctx.count = CALIBRATE_MAX_COPIES;
+    BenchTask task = {calibrate_prepare, calibrate_run, calibrate_cleanup, &ctx};
+
+    BenchStats stats;
+    double t[2] = {BENCH_ERROR, BENCH_ERROR};
+    void (*sorts[2])(Queue *q) = {a, b};
+    for (int s = 0; s < 2; s++) {
+        ctx.sort = sorts[s];
+        if (bench_measure(&calibrate_config, &task, &stats) == BENCH_OK)
+            t[s] = stats.median;
+    }
+    queue_free(&q);
+    return t[0] >= 0 && t[1] >= 0 && t[0] <= t[1];
+}
+
+// Пороги автовыбора для одного вида хранилища: каждый порог - граница,
+// за которой частный случай перестает обгонять сортировку общего случая
+// large. values - буфер на CALIBRATE_MAX_PARALLEL чисел
+static void calibrate_kind(QueueBackend backend, void (*large)(Queue *q),
+                           QueueSortThresholds *th, int *values)
+{
+    // Маленькие очереди: адаптивная сортировка (вставки) на случайных числах
+    th->small_size = 0;
+    for (size_t n = 8; n <= CALIBRATE_MAX_SMALL; n *= 2) {
+        bench_fill(values, n, BENCH_DIST_RANDOM);
+        if (!calibrate_wins(backend, values, n, queue_adaptive_sort, large))
+            break;
+        th->small_size = n;
+    }
+    printf("   адаптивная до %zu элементов\n", th->small_size);
+
+    // Почти упорядоченные данные: упорядоченные серии длины len подряд
+    size_t n = CALIBRATE_RUNS_SIZE;
+    th->run_ratio = n;      // Адаптивная не выигрывает ни при какой длине серий
+    for (size_t len = 2; len < n; len *= 2) {
+        bench_fill(values, n, BENCH_DIST_RANDOM);
+        for (size_t i = 0; i < n; i += len)
+            simd_sort_ints(values + i, n - i < len ? n - i : len);
+        if (calibrate_wins(backend, values, n, queue_adaptive_sort, large)) {
+            th->run_ratio = len / 2;
+            break;
+        }
+    }
+    printf("   адаптивная при средней длине серии больше %zu\n", th->run_ratio);
+
+    // Узкий диапазон значений: наибольшее отношение диапазон/размер, где подсчет быстрее
+    n = CALIBRATE_COUNTING_SIZE;
+    th->counting_ratio = 0;
+    for (int k = 0; k < NUM_COUNTING_RATIOS; k++) {
+        size_t range = n * counting_ratios[k] / 64;
+        if (range > QUEUE_COUNTING_MAX_RANGE)
+            break;
+        fill_range(values, n, range);
+        if (!calibrate_wins(backend, values, n, queue_counting_sort, large))
+            break;
+        th->counting_ratio = counting_ratios[k] / 64.0;
+    }
+    printf("   подсчет при диапазоне до %g * размер\n", th->counting_ratio);
+
+    // Большие списки: параллельная сортировка, если ядер больше одного
+    th->parallel_size = 0;
+    if (backend == QUEUE_BACKEND_LIST && queue_default_threads() > 1) {
+        for (n = CALIBRATE_MIN_PARALLEL; n <= CALIBRATE_MAX_PARALLEL; n *= 2) {
+            bench_fill(values, n, BENCH_DIST_RANDOM);
+            if (calibrate_wins(backend, values, n, sort_parallel_all_cores, large)) {
+                th->parallel_size = n;
+                break;
+            }
+        }
+    }
+    if (backend == QUEUE_BACKEND_LIST) {
+        if (th->parallel_size > 0)
+            printf("   параллельная с %zu элементов\n", th->parallel_size);
+        else
+            printf("   параллельная не выигрывает (ядер: %d)\n", queue_default_threads());
+    }
+}
+
+// Калибровка порогов queue_sort_auto на этой машине: замеры для списка
+// и для кольцевого буфера (его пороги действуют и для списка блоков),
+// результат сохраняется в профиль и читается при следующих запусках
+void handle_calibrate(void)
+{
+    printf("Калибровка автовыбора сортировки\n");
+    print_separator('=', 48);
+
+    int *values = (int *)malloc(CALIBRATE_MAX_PARALLEL * sizeof(int));
+    if (!values) {
+        printf("Ошибка выделения памяти\n");
+        return;
+    }
+    srand((unsigned)time(NULL));
+
+    QueueSortTuning tuning;
+    printf("Список:\n");
+    calibrate_kind(QUEUE_BACKEND_LIST, queue_simd_sort, &tuning.list, values);
+    printf("Массив (кольцевой буфер):\n");
+    calibrate_kind(QUEUE_BACKEND_RING, queue_radix_sort, &tuning.array, values);
+    free(values);
+
+    queue_sort_tuning_set(&tuning);
+    printf("\n");
+    sort_profile_write(stdout, &tuning);
+    if (sort_profile_save(SORT_PROFILE_FILE, &tuning) == 0)
+        printf("\nПрофиль сохранен в файл \"%s\"\n", SORT_PROFILE_FILE);
+    else
+        printf("\nОшибка записи профиля \"%s\"\n", SORT_PROFILE_FILE);
+}
+
+/* ==================== КОНКУРЕНТНЫЕ ОЧЕРЕДИ ==================== */
+
+// Вариант очереди в тесте пропускной способности
+typedef enum CQueueBenchKind {
+    CQB_MPMC,           // CQueue, по одному значению
+    CQB_MPMC_BATCH,     // CQueue, пакетами
+    CQB_SPSC,           // CQueueSpsc, по одному значению
+    CQB_SPSC_BATCH,     // CQueueSpsc, пакетами
+    CQB_MUTEX           // Обычная Queue под мьютексом
+} CQueueBenchKind;
+
+#define CQB_TOTAL_OPS  (1 << 21)    // Значений на один тест
+#define CQB_CAPACITY   4096         // Емкость конкурентных очередей
+#define CQB_BATCH      64           // Размер пакета
+
+static const char *cqueue_bench_names[] = {
+    "MPMC", "MPMC пакетами", "SPSC", "SPSC пакетами", "Queue + мьютекс"
+};
+
+// Общие данные теста и параметры одного потока
+typedef struct CQueueBench {
+    CQueueBenchKind kind;
+    CQueue mpmc;
+    CQueueSpsc spsc;
+    Queue locked;
+    pthread_mutex_t lock;
+} CQueueBench;
+
+typedef struct CQueueBenchThread {
+    CQueueBench *bench;
+    size_t first;               // Первое значение производителя
+    size_t count;               // Сколько значений записать или прочитать
+    long long checksum;         // Сумма прочитанных значений (у потребителя)
+} CQueueBenchThread;
+
+static void *cqueue_bench_producer(void *arg)
+{
+    CQueueBenchThread *t = (CQueueBenchThread *)arg;
+    CQueueBench *b = t->bench;
+    int batch[CQB_BATCH];
+    size_t done = 0;
+
+    while (done < t->count) {
+        switch (b->kind) {
+        case CQB_MPMC:
+            cqueue_push(&b->mpmc, (int)(t->first + done));
+            done++;
+            break;
+        case CQB_SPSC:
+            cqueue_spsc_push(&b->spsc, (int)(t->first + done));
+            done++;
+            break;
+        case CQB_MPMC_BATCH:
+        case CQB_SPSC_BATCH: {
+            size_t n = t->count - done < CQB_BATCH ? t->count - done : CQB_BATCH;
+            for (size_t i = 0; i < n; i++)
+                batch[i] = (int)(t->first + done + i);
+            size_t sent = 0;
+            while (sent < n) {
+                size_t k = (b->kind == CQB_MPMC_BATCH)
+                    ? cqueue_try_push_n(&b->mpmc, batch + sent, n - sent)
+                    : cqueue_spsc_try_push_n(&b->spsc, batch + sent, n - sent);
+                if (k == 0)
+                    sched_yield();
+                sent += k;
+            }
+            done += n;
+            break;
+        }
+        case CQB_MUTEX:
+            pthread_mutex_lock(&b->lock);
+            queue_push(&b->locked, (int)(t->first + done));
+            pthread_mutex_unlock(&b->lock);
+            done++;
+            break;
+        }
+    }
+    return NULL;
+}
+
+static void *cqueue_bench_consumer(void *arg)
+{
+    CQueueBenchThread *t = (CQueueBenchThread *)arg;
+    CQueueBench *b = t->bench;
+    int batch[CQB_BATCH];
+    size_t done = 0;
+    int value;
+
+    while (done < t->count) {
+        switch (b->kind) {
+        case CQB_MPMC:
+            cqueue_pop(&b->mpmc, &value);
+            t->checksum += value;
+            done++;
+            break;
+        case CQB_SPSC:
+            cqueue_spsc_pop(&b->spsc, &value);
+            t->checksum += value;
+            done++;
+            break;
+        case CQB_MPMC_BATCH:
+        case CQB_SPSC_BATCH: {
+            size_t want = t->count - done < CQB_BATCH ? t->count - done : CQB_BATCH;
+            size_t k = (b->kind == CQB_MPMC_BATCH)
+                ? cqueue_try_pop_n(&b->mpmc, batch, want)
+                : cqueue_spsc_try_pop_n(&b->spsc, batch, want);
+            if (k == 0)
+                sched_yield();
+            for (size_t i = 0; i < k; i++)
+                t->checksum += batch[i];
+            done += k;
+            break;
+        }
+        case CQB_MUTEX: {
+            pthread_mutex_lock(&b->lock);
+            int ok = queue_pop(&b->locked, &value) == 0;
+            pthread_mutex_unlock(&b->lock);
+            if (ok) {
+                t->checksum += value;
+                done++;
+            } else {
+                sched_yield();
+            }
+            break;
+        }
+        }
+    }
+    return NULL;
+}
+
+// Один тест: producers потоков пишут, consumers потоков читают CQB_TOTAL_OPS значений
+// Возвращает время в секундах или -1 при ошибке (в т.ч. несовпадении контрольной суммы)
+static double run_cqueue_bench(CQueueBench *b, CQueueBenchKind kind, int producers, int consumers)
+{
+    pthread_t handles[2 * QUEUE_MAX_THREADS];
+    CQueueBenchThread threads[2 * QUEUE_MAX_THREADS];
+    int total = producers + consumers;
+
+    b->kind = kind;
+    memset(threads, 0, sizeof(threads));
+    for (int i = 0; i < producers; i++) {
+        threads[i].bench = b;
+        threads[i].first = (size_t)i * (CQB_TOTAL_OPS / producers) +
+                           (i < CQB_TOTAL_OPS % producers ? i : CQB_TOTAL_OPS % producers);
+        threads[i].count = CQB_TOTAL_OPS / producers + (i < CQB_TOTAL_OPS % producers);
+    }
+    for (int i = 0; i < consumers; i++) {
+        threads[producers + i].bench = b;
+        threads[producers + i].count = CQB_TOTAL_OPS / consumers + (i < CQB_TOTAL_OPS % consumers);
+    }
+
+    double start = bench_now();
+    int created = 0;
+    for (; created < total; created++) {
+        void *(*fn)(void *) = created < producers ? cqueue_bench_producer : cqueue_bench_consumer;
+        if (pthread_create(&handles[created], NULL, fn, &threads[created]) != 0)
+            break;
+    }
+    for (int i = 0; i < created; i++)
+        pthread_join(handles[i], NULL);
+    double elapsed = bench_now() - start;
+
+    if (created < total) {
+        printf("Не удалось создать потоки.\n");
+        return -1;
+    }
+
+    long long checksum = 0;
+    for (int i = 0; i < consumers; i++)
+        checksum += threads[producers + i].checksum;
+    long long expected = (long long)CQB_TOTAL_OPS * (CQB_TOTAL_OPS - 1) / 2;
+    if (checksum != expected) {
+        printf("Ошибка: контрольная сумма не совпала (%lld вместо %lld)\n", checksum, expected);
+        return -1;
+    }
+    return elapsed;
+}
+
+// Тест пропускной способности конкурентных очередей для 1..N потоков
+void benchmark_concurrent(void)
+{
+    printf("Тестирование конкурентных очередей\n");
+    print_separator('=', 48);
+
+    if (ensure_results_dir() != 0)
+        return;
+
+    static CQueueBench bench;
+    if (cqueue_init(&bench.mpmc, CQB_CAPACITY) != 0 ||
+        cqueue_spsc_init(&bench.spsc, CQB_CAPACITY) != 0) {
+        printf("Ошибка выделения памяти для очередей\n");
+        cqueue_free(&bench.mpmc);
+        return;
+    }
+    queue_init(&bench.locked);
+    pthread_mutex_init(&bench.lock, NULL);
+
+    char timestamp[64];
+    time_t now = time(NULL);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
+
+    char csv_filename[256];
+    snprintf(csv_filename, sizeof(csv_filename),
+             "benchmark_results/benchmark_cqueue_%s.csv", timestamp);
+    for (int i = 0; csv_filename[i]; i++) {
+        if (csv_filename[i] == ':') csv_filename[i] = '-';
+        if (csv_filename[i] == ' ') csv_filename[i] = '_';
+    }
+    FILE *csv = fopen(csv_filename, "w");
+    if (csv)
+        fprintf(csv, "Вариант;Производители;Потребители;Операций;Время (сек);Млн операций/сек;Дата теста\n");
+
+    // Число потоков каждой стороны: 1, 2, 4, ... и число ядер
+    int max_threads = queue_default_threads();
+    if (max_threads < 2)
+        max_threads = 2;
+    int counts[16];
+    int num_counts = 0;
+    for (int k = 1; k < max_threads && num_counts < 15; k *= 2)
+        counts[num_counts++] = k;
+    counts[num_counts++] = max_threads;
+
+    printf("\n%-18s | %-6s | %-6s | %-12s | %-12s\n",
+           "Вариант", "Произв", "Потреб", "Время (сек)", "Млн оп/сек");
+    print_separator('-', 66);
+
+    for (int c = 0; c < num_counts; c++) {
+        int k = counts[c];
+        for (int kind = CQB_MPMC; kind <= CQB_MUTEX; kind++) {
+            // SPSC-очередь допускает только по одному потоку с каждой стороны
+            if ((kind == CQB_SPSC || kind == CQB_SPSC_BATCH) && k != 1)
+                continue;
+
+            double elapsed = run_cqueue_bench(&bench, (CQueueBenchKind)kind, k, k);
+            if (elapsed < 0)
+                continue;
+            double mops = CQB_TOTAL_OPS / elapsed / 1e6;
+            printf("%-18s | %-6d | %-6d | %-12.6f | %-12.2f\n",
+                   cqueue_bench_names[kind], k, k, elapsed, mops);
+            if (csv)
+                fprintf(csv, "%s;%d;%d;%d;%.6f;%.2f;%s\n", cqueue_bench_names[kind],
+                        k, k, CQB_TOTAL_OPS, elapsed, mops, timestamp);
+        }
+    }
+
+    if (csv) {
+        fclose(csv);
+        printf("\nРезультаты сохранены в CSV файл: %s\n", csv_filename);
+    }
+
+    pthread_mutex_destroy(&bench.lock);
+    queue_free(&bench.locked);
+    cqueue_free(&bench.mpmc);
+    cqueue_spsc_free(&bench.spsc);
+}
@@ -0,0 +1,542 @@
+#include "bench.h"
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/utsname.h>
+#include <sys/wait.h>
+
+void bench_default_config(BenchConfig *config)
+{
+    config->warmup = 1;
+    config->repetitions = 5;
+    config->time_budget = 10.0;
+    config->timeout = 60.0;
+    config->perf_counters = 0;
+}
+
+double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Один запуск: время и значения счетчиков (-1 - счетчик не снимался)
+typedef struct BenchSample {
+    double seconds;
+    double counters[PERF_COUNTER_COUNT];
+} BenchSample;
+
+// Один запуск: подготовка, замер, уборка; 0 - успех
+static int bench_once(const BenchTask *task, PerfCounters *pc, BenchSample *sample)
+{
+    if (task->prepare && task->prepare(task->ctx) != 0)
+        return -1;
+
+    if (pc)
+        perf_counters_start(pc);
+    double start = bench_now();
+    task->run(task->ctx);
+    sample->seconds = bench_now() - start;
+    if (pc) {
+        perf_counters_stop(pc, sample->counters);
+    } else {
+        for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+            sample->counters[i] = -1;
+    }
+
+    if (task->cleanup)
+        task->cleanup(task->ctx);
+    return 0;
+}
+
+// Передача замера родительскому процессу; 0 - успех (или канала нет)
+static int send_sample(int fd, const BenchSample *sample)
+{
+    if (fd < 0)
+        return 0;
+    return write(fd, sample, sizeof(*sample)) == (ssize_t)sizeof(*sample) ? 0 : -1;
+}
+
+// Прогрев и замеры; каждый замер, если fd >= 0, сразу пишется в канал,
+// чтобы при снятии процесса родитель сохранил уже сделанные.
+// Долгие замеры ограничены бюджетом времени: медленный алгоритм
+// на большом размере дает меньше замеров, но хотя бы один
+static int bench_collect(const BenchConfig *config, const BenchTask *task,
+                         BenchSample *samples, int fd)
+{
+    int repetitions = config->repetitions;
+    if (repetitions < 1)
+        repetitions = 1;
+    if (repetitions > BENCH_MAX_SAMPLES)
+        repetitions = BENCH_MAX_SAMPLES;
+
+    // Счетчики открываются в том процессе, где идут запуски
+    PerfCounters counters;
+    PerfCounters *pc = NULL;
+    if (config->perf_counters && perf_counters_open(&counters) > 0)
+        pc = &counters;
+
+    double spent = 0;
+    int count = 0;
+    for (int i = 0; i < config->warmup; i++) {
+        if (bench_once(task, pc, &samples[count]) != 0)
+            break;
+        spent += samples[count].seconds;
+        // Запуск дольше бюджета не нуждается в прогреве: он и есть замер
+        if (config->time_budget > 0 && spent >= config->time_budget) {
+            send_sample(fd, &samples[count++]);
+            repetitions = 0;
+            break;
+        }
+    }
+
+    while (count < repetitions) {
+        if (bench_once(task, pc, &samples[count]) != 0)
+            break;
+        spent += samples[count].seconds;
+        if (send_sample(fd, &samples[count++]) != 0)
+            break;
+        if (config->time_budget > 0 && spent >= config->time_budget)
+            break;
+    }
+
+    if (pc)
+        perf_counters_close(pc);
+    return count;
+}
+
+// Статистика времени и медианы счетчиков по замерам
+static void bench_finish(const BenchSample *samples, int count, BenchStats *stats)
+{
+    double values[BENCH_MAX_SAMPLES];
+    for (int i = 0; i < count; i++)
+        values[i] = samples[i].seconds;
+    bench_compute_stats(values, count, stats);
+
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+        int valid = count > 0;
+        for (int i = 0; i < count && valid; i++) {
+            values[i] = samples[i].counters[c];
+            valid = values[i] >= 0;
+        }
+        if (valid) {
+            BenchStats counter_stats;
+            bench_compute_stats(values, count, &counter_stats);
+            stats->counters[c] = counter_stats.median;
+        }
+    }
+}
+
+// Замер в дочернем процессе: родитель читает замеры из канала до его
+// закрытия или до таймаута, после которого процесс снимается
+static int bench_measure_forked(const BenchConfig *config, const BenchTask *task,
+                                BenchStats *stats)
+{
+    BenchSample samples[BENCH_MAX_SAMPLES];
+    int count = 0;
+    int fds[2];
+
+    if (pipe(fds) != 0) {
+        bench_finish(samples, 0, stats);
+        return BENCH_ERROR;
+    }
+    // Иначе недописанный буфер вывода попадет на экран дважды
+    fflush(stdout);
+    fflush(stderr);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        bench_finish(samples, 0, stats);
+        return BENCH_ERROR;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        bench_collect(config, task, samples, fds[1]);
+        _exit(0);
+    }
+    close(fds[1]);
+
+    int status = BENCH_OK;
+    double deadline = bench_now() + config->timeout;
+    unsigned char buf[sizeof(BenchSample)];
+    size_t got = 0;
+    for (;;) {
+        double left = deadline - bench_now();
+        if (left <= 0) {
+            status = BENCH_TIMEOUT;
+            break;
+        }
+        struct pollfd pfd = {fds[0], POLLIN, 0};
+        int ready = poll(&pfd, 1, left > 3600 ? 3600000 : (int)(left * 1000) + 1);
+        if (ready < 0 && errno != EINTR) {
+            status = BENCH_ERROR;
+            break;
+        }
+        if (ready <= 0)
+            continue;
+
+        ssize_t n = read(fds[0], buf + got, sizeof(buf) - got);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;              // Канал закрыт: процесс закончил или упал
+        got += (size_t)n;
+        if (got == sizeof(buf)) {
+            if (count < BENCH_MAX_SAMPLES)
+                memcpy(&samples[count++], buf, sizeof(BenchSample));
+            got = 0;
+        }
+    }
+    close(fds[0]);
+
+    if (status != BENCH_OK)
+        kill(pid, SIGKILL);
+    // wait4 заодно сообщает пиковый RSS именно этого процесса
+    int wstatus = 0;
+    struct rusage usage;
+    memset(&usage, 0, sizeof(usage));
+    while (wait4(pid, &wstatus, 0, &usage) < 0 && errno == EINTR) {}
+    if (status == BENCH_OK) {
+        if (!WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0)
+            status = BENCH_CRASHED;
+        else if (count == 0)
+            status = BENCH_ERROR;
+    }
+
+    bench_finish(samples, count, stats);
+    stats->peak_rss_kb = usage.ru_maxrss;
+    return status;
+}
+
+int bench_measure(const BenchConfig *config, const BenchTask *task, BenchStats *stats)
+{
+    if (config->timeout > 0)
+        return bench_measure_forked(config, task, stats);
+
+    BenchSample samples[BENCH_MAX_SAMPLES];
+    int count = bench_collect(config, task, samples, -1);
+    bench_finish(samples, count, stats);
+    stats->peak_rss_kb = bench_peak_rss_kb();
+    return count > 0 ? BENCH_OK : BENCH_ERROR;
+}
+
+long bench_peak_rss_kb(void)
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return usage.ru_maxrss;
+}
+
+const char* bench_status_name(int status)
+{
+    switch (status) {
+    case BENCH_OK:
+        return "ok";
+    case BENCH_TIMEOUT:
+        return "timeout";
+    case BENCH_CRASHED:
+        return "crash";
+    default:
+        return "error";
+    }
+}
+
+/* ==================== РАСПРЕДЕЛЕНИЯ ДАННЫХ ==================== */
+
+static const char *distribution_names[BENCH_DIST_COUNT] = {
+    "random", "sorted", "reversed", "nearly_sorted",
+    "few_unique", "organ_pipe", "sawtooth", "all_equal"
+};
+
+const char* bench_distribution_name(BenchDistribution dist)
+{
+    if (dist < 0 || dist >= BENCH_DIST_COUNT)
+        return "unknown";
+    return distribution_names[dist];
+}
+
+// Случайное число от 0 до n - 1 (rand() дает лишь 15 бит на некоторых системах)
+static size_t random_index(size_t n)
+{
+    uint64_t r = ((uint64_t)rand() << 31) ^ (uint64_t)rand();
+    return (size_t)(r % n);
+}
+
+// Значения растут от 0 до 999999 по длине массива
+static int ramp_value(size_t i, size_t n)
+{
+    return (int)((uint64_t)i * 1000000 / n);
+}
+
+void bench_fill(int *values, size_t n, BenchDistribution dist)
+{
+    if (n == 0)
+        return;
+
+    switch (dist) {
+    case BENCH_DIST_SORTED:
+        for (size_t i = 0; i < n; i++)
+            values[i] = ramp_value(i, n);
+        break;
+    case BENCH_DIST_REVERSED:
+        for (size_t i = 0; i < n; i++)
+            values[i] = ramp_value(n - 1 - i, n);
+        break;
+    case BENCH_DIST_NEARLY_SORTED: {
+        for (size_t i = 0; i < n; i++)
+            values[i] = ramp_value(i, n);
+        size_t swaps = n / 100 + 1;
+        for (size_t k = 0; k < swaps; k++) {
+            size_t a = random_index(n), b = random_index(n);
+            int tmp = values[a];
+            values[a] = values[b];
+            values[b] = tmp;
+        }
+        break;
+    }
+    case BENCH_DIST_FEW_UNIQUE:
+        for (size_t i = 0; i < n; i++)
+            values[i] = rand() % 16 * 62500;
+        break;
+    case BENCH_DIST_ORGAN_PIPE:
+        for (size_t i = 0; i < n; i++)
+            values[i] = ramp_value(i < n / 2 ? i : n - 1 - i, n);
+        break;
+    case BENCH_DIST_SAWTOOTH: {
+        size_t period = n / 8 + 1;
+        for (size_t i = 0; i < n; i++)
+            values[i] = ramp_value(i % period, period);
+        break;
+    }
+    case BENCH_DIST_ALL_EQUAL:
+        for (size_t i = 0; i < n; i++)
+            values[i] = 500000;
+        break;
+    default:
+        for (size_t i = 0; i < n; i++)
+            values[i] = rand() % 1000000;
+        break;
+    }
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+void bench_compute_stats(double *samples, int count, BenchStats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++)
+        stats->counters[c] = -1;
+    stats->samples = count;
+    if (count == 0)
+        return;
+
+    qsort(samples, (size_t)count, sizeof(double), compare_doubles);
+
+    double sum = 0;
+    for (int i = 0; i < count; i++)
+        sum += samples[i];
+    stats->mean = sum / count;
+    stats->min = samples[0];
+    stats->max = samples[count - 1];
+    stats->median = count % 2 ? samples[count / 2]
+                              : (samples[count / 2 - 1] + samples[count / 2]) / 2;
+
+    // 95-й процентиль по ближайшему рангу
+    int rank = (int)ceil(0.95 * count);
+    stats->p95 = samples[rank > 0 ? rank - 1 : 0];
+
+    if (count > 1) {
+        double sq = 0;
+        for (int i = 0; i < count; i++)
+            sq += (samples[i] - stats->mean) * (samples[i] - stats->mean);
+        stats->stddev = sqrt(sq / (count - 1));
+    }
+}
+
+// Название процессора из /proc/cpuinfo (на других системах - "unknown")
+static void read_cpu_model(char *out, size_t size)
+{
+    snprintf(out, size, "unknown");
+    FILE *f = fopen("/proc/cpuinfo", "r");
+    if (!f)
+        return;
+
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "model name", 10) != 0)
+            continue;
+        char *value = strchr(line, ':');
+        if (value) {
+            value += 1 + (value[1] == ' ');
+            value[strcspn(value, "\n")] = 0;
+            snprintf(out, size, "%s", value);
+        }
+        break;
+    }
+    fclose(f);
+}
+
+void bench_machine_info(BenchMachine *machine)
+{
+    memset(machine, 0, sizeof(*machine));
+
+    if (gethostname(machine->hostname, sizeof(machine->hostname) - 1) != 0)
+        snprintf(machine->hostname, sizeof(machine->hostname), "unknown");
+    read_cpu_model(machine->cpu_model, sizeof(machine->cpu_model));
+
+    struct utsname u;
+    if (uname(&u) == 0)
+        snprintf(machine->kernel, sizeof(machine->kernel), "%s %s %s",
+                 u.sysname, u.release, u.machine);
+    else
+        snprintf(machine->kernel, sizeof(machine->kernel), "unknown");
+
+#if defined(__clang__)
+    snprintf(machine->compiler, sizeof(machine->compiler), "clang %s", __clang_version__);
+#elif defined(__GNUC__)
+    snprintf(machine->compiler, sizeof(machine->compiler), "gcc %s", __VERSION__);
+#else
+    snprintf(machine->compiler, sizeof(machine->compiler), "unknown");
+#endif
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    machine->cpus = cpus > 0 ? (int)cpus : 1;
+
+    time_t now = time(NULL);
+    strftime(machine->timestamp, sizeof(machine->timestamp), "%Y-%m-%dT%H:%M:%S",
+             localtime(&now));
+}
+
+int bench_save_csv(const char *filename, const BenchResult *results, size_t count,
+                   const BenchMachine *machine, const BenchConfig *config)
+{
+    FILE *f = fopen(filename, "w");
+    if (!f)
+        return -1;
+
+    // Разделитель - точка с запятой, как в остальных CSV для Excel
+    fprintf(f, "# %s; %s; %s; CPU: %s x%d; %s; прогрев %d, замеров %d, таймаут %.0f сек\n",
+            machine->timestamp, machine->hostname, machine->kernel,
+            machine->cpu_model, machine->cpus, machine->setup,
+            config->warmup, config->repetitions, config->timeout);
+    fprintf(f, "Распределение;Алгоритм;Размер;Итог;Замеров;Медиана (сек);Минимум (сек);"
+               "P95 (сек);Среднее (сек);Ст. отклонение (сек);Пиковый RSS (КБ)");
+    if (config->perf_counters) {
+        for (int c = 0; c < PERF_COUNTER_COUNT; c++)
+            fprintf(f, ";%s/эл.", perf_counter_name((PerfCounterId)c));
+        fprintf(f, ";IPC");
+    }
+    fprintf(f, "\n");
+    for (size_t i = 0; i < count; i++) {
+        const BenchStats *s = &results[i].stats;
+        fprintf(f, "%s;%s;%zu;%s;%d;%.9f;%.9f;%.9f;%.9f;%.9f;%ld",
+                results[i].distribution ? results[i].distribution : "", results[i].name,
+                results[i].size, bench_status_name(results[i].status), s->samples,
+                s->median, s->min, s->p95, s->mean, s->stddev, s->peak_rss_kb);
+        // Счетчики на элемент; пустая ячейка - счетчик недоступен
+        if (config->perf_counters) {
+            for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+                if (s->counters[c] >= 0 && results[i].size > 0)
+                    fprintf(f, ";%.4f", s->counters[c] / (double)results[i].size);
+                else
+                    fprintf(f, ";");
+            }
+            if (s->counters[PERF_CYCLES] > 0 && s->counters[PERF_INSTRUCTIONS] >= 0)
+                fprintf(f, ";%.3f", s->counters[PERF_INSTRUCTIONS] / s->counters[PERF_CYCLES]);
+            else
+                fprintf(f, ";");
+        }
+        fprintf(f, "\n");
+    }
+
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+// Строка JSON с экранированием кавычек, обратной косой черты и управляющих
+static void json_string(FILE *f, const char *s)
+{
+    fputc('"', f);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\')
+            fprintf(f, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(f, "\\u%04x", c);
+        else
+            fputc(c, f);
+    }
+    fputc('"', f);
+}
+
+int bench_save_json(const char *filename, const BenchResult *results, size_t count,
+                    const BenchMachine *machine, const BenchConfig *config)
+{
+    FILE *f = fopen(filename, "w");
+    if (!f)
+        return -1;
+
+    fprintf(f, "{\n  \"machine\": {\n    \"hostname\": ");
+    json_string(f, machine->hostname);
+    fprintf(f, ",\n    \"cpu_model\": ");
+    json_string(f, machine->cpu_model);
+    fprintf(f, ",\n    \"cpus\": %d,\n    \"kernel\": ", machine->cpus);
+    json_string(f, machine->kernel);
+    fprintf(f, ",\n    \"compiler\": ");
+    json_string(f, machine->compiler);
+    fprintf(f, ",\n    \"timestamp\": ");
+    json_string(f, machine->timestamp);
+    fprintf(f, ",\n    \"setup\": ");
+    json_string(f, machine->setup);
+    fprintf(f, "\n  },\n  \"config\": {\"warmup\": %d, \"repetitions\": %d, "
+               "\"time_budget\": %.3f, \"timeout\": %.3f, \"perf_counters\": %s},\n"
+               "  \"results\": [",
+            config->warmup, config->repetitions, config->time_budget, config->timeout,
+            config->perf_counters ? "true" : "false");
+
+    for (size_t i = 0; i < count; i++) {
+        const BenchStats *s = &results[i].stats;
+        fprintf(f, "%s\n    {\"name\": ", i ? "," : "");
+        json_string(f, results[i].name);
+        fprintf(f, ", \"distribution\": ");
+        json_string(f, results[i].distribution ? results[i].distribution : "");
+        fprintf(f, ", \"status\": ");
+        json_string(f, bench_status_name(results[i].status));
+        fprintf(f, ", \"size\": %zu, \"samples\": %d, \"median\": %.9f, \"min\": %.9f, "
+                   "\"p95\": %.9f, \"max\": %.9f, \"mean\": %.9f, \"stddev\": %.9f, "
+                   "\"peak_rss_kb\": %ld",
+                results[i].size, s->samples, s->median, s->min, s->p95, s->max,
+                s->mean, s->stddev, s->peak_rss_kb);
+        // Счетчики на элемент; null - счетчик недоступен
+        if (config->perf_counters) {
+            fprintf(f, ", \"counters_per_element\": {");
+            for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+                fprintf(f, "%s\"%s\": ", c ? ", " : "", perf_counter_name((PerfCounterId)c));
+                if (s->counters[c] >= 0 && results[i].size > 0)
+                    fprintf(f, "%.4f", s->counters[c] / (double)results[i].size);
+                else
+                    fprintf(f, "null");
+            }
+            fprintf(f, "}");
+        }
+        fprintf(f, "}");
+    }
+    fprintf(f, "\n  ]\n}\n");
+
+    return fclose(f) == 0 ? 0 : -1;
+}
@@ -0,0 +1,124 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+#include "perf_counters.h"
+
+//ЗАМЕРЫ ВРЕМЕНИ ДЛЯ СРАВНЕНИЯ СКОРОСТЕЙ
+//Время берется по CLOCK_MONOTONIC (наносекунды, а не тики clock()).
+//Каждый замер повторяется: сначала прогревочные запуски без учета,
+//затем repetitions замеров, по которым считаются медиана, минимум,
+//95-й процентиль и стандартное отклонение. Подготовка данных перед
+//каждым запуском (например, копирование очереди) в замер не входит.
+//При заданном таймауте замер идет в дочернем процессе: зависший
+//(O(n^2)) или упавший алгоритм снимается, а набор тестов продолжается.
+//По желанию каждый запуск оборачивается аппаратными счетчиками процессора.
+
+#define BENCH_MAX_SAMPLES 1000
+
+//Итог замера (код возврата bench_measure и поле BenchResult.status)
+#define BENCH_OK        0
+#define BENCH_ERROR    -1       // Не удалось подготовить данные или запустить процесс
+#define BENCH_TIMEOUT  -2       // Превышен таймаут, процесс остановлен
+#define BENCH_CRASHED  -3       // Процесс замера аварийно завершился
+
+//Параметры замера
+typedef struct BenchConfig {
+    int warmup;                 // Прогревочных запусков (без учета)
+    int repetitions;            // Замеров
+    double time_budget;         // Секунд на один замер; 0 - без ограничения
+    double timeout;             // Секунд до снятия замера; 0 - без процесса и таймаута
+    int perf_counters;          // Снимать аппаратные счетчики (perf_counters.h)
+} BenchConfig;
+
+//Распределения входных данных
+typedef enum BenchDistribution {
+    BENCH_DIST_RANDOM = 0,      // Случайные числа от 0 до 999999
+    BENCH_DIST_SORTED,          // По возрастанию
+    BENCH_DIST_REVERSED,        // По убыванию
+    BENCH_DIST_NEARLY_SORTED,   // По возрастанию, 1% случайных перестановок
+    BENCH_DIST_FEW_UNIQUE,      // 16 различных значений
+    BENCH_DIST_ORGAN_PIPE,      // Возрастание до середины, затем убывание
+    BENCH_DIST_SAWTOOTH,        // 8 возрастающих "зубцов"
+    BENCH_DIST_ALL_EQUAL,       // Все значения одинаковы
+    BENCH_DIST_COUNT
+} BenchDistribution;
+
+//Статистика по замерам, секунды
+typedef struct BenchStats {
+    int samples;                // Сколько замеров удалось сделать
+    double min;
+    double median;
+    double mean;
+    double p95;
+    double max;
+    double stddev;
+    double counters[PERF_COUNTER_COUNT];  // Медианы счетчиков за запуск; -1 - нет данных
+    long peak_rss_kb;           // Пиковый RSS процесса замеров, КБ (0 - неизвестен)
+} BenchStats;
+
+//Один результат для сохранения: что, на каком размере и как быстро
+typedef struct BenchResult {
+    const char *name;
+    const char *distribution;   // Название распределения данных
+    size_t size;
+    int status;                 // BENCH_OK или код ошибки
+    BenchStats stats;
+} BenchResult;
+
+//Сведения о машине для воспроизводимости результатов
+typedef struct BenchMachine {
+    char hostname[64];
+    char cpu_model[128];
+    char kernel[200];
+    char compiler[64];
+    int cpus;
+    char timestamp[32];
+    char setup[128];            // Настройки программы (заполняет вызывающий)
+} BenchMachine;
+
+//Действия одного замера; prepare и cleanup не замеряются
+//(любое из трех может быть NULL, кроме run). 0 - успех
+typedef struct BenchTask {
+    int  (*prepare)(void *ctx);
+    void (*run)(void *ctx);
+    void (*cleanup)(void *ctx);
+    void *ctx;
+} BenchTask;
+
+//Параметры по умолчанию: 1 прогрев, 5 замеров, 10 секунд, таймаут 60 секунд,
+//без счетчиков
+void bench_default_config(BenchConfig *config);
+
+//Монотонное время в секундах
+double bench_now(void);
+
+//Прогрев и замеры задачи; BENCH_OK или код ошибки. При таймауте
+//или падении в stats остаются замеры, сделанные до остановки
+int bench_measure(const BenchConfig *config, const BenchTask *task, BenchStats *stats);
+
+//Короткое название итога замера ("ok", "timeout", "crash", "error")
+const char* bench_status_name(int status);
+
+//Заполнение массива данными заданного распределения (использует rand())
+void bench_fill(int *values, size_t n, BenchDistribution dist);
+
+//Название распределения для вывода и файлов ("random", "sorted", ...)
+const char* bench_distribution_name(BenchDistribution dist);
+
+//Пиковый RSS текущего процесса, КБ (0 - неизвестен)
+long bench_peak_rss_kb(void);
+
+//Статистика по массиву замеров (массив сортируется)
+void bench_compute_stats(double *samples, int count, BenchStats *stats);
+
+void bench_machine_info(BenchMachine *machine);
+
+//Сохранение результатов: CSV - по строке на результат,
+//JSON - с параметрами и сведениями о машине. 0 - успех
+int bench_save_csv(const char *filename, const BenchResult *results, size_t count,
+                   const BenchMachine *machine, const BenchConfig *config);
+int bench_save_json(const char *filename, const BenchResult *results, size_t count,
+                    const BenchMachine *machine, const BenchConfig *config);
+
+#endif /* BENCH_H */
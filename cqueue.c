@@ -0,0 +1,305 @@
+#include "cqueue.h"
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Сколько раз крутиться вхолостую перед тем, как уступить процессор
+#define CQUEUE_SPIN_LIMIT 64
+
+// Ожидание в блокирующих push/pop
+static void cqueue_backoff(unsigned *spins)
+{
+    if (++*spins < CQUEUE_SPIN_LIMIT) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_ia32_pause();
+#endif
+    } else {
+        *spins = 0;
+        sched_yield();
+    }
+}
+
+// Ближайшая степень двойки, не меньшая capacity (минимум 2)
+static size_t round_up_pow2(size_t capacity)
+{
+    size_t size = 2;
+    while (size < capacity)
+        size *= 2;
+    return size;
+}
+
+/* ==================== MPMC ==================== */
+
+int cqueue_init(CQueue *q, size_t capacity)
+{
+    size_t size = round_up_pow2(capacity);
+    q->cells = (CQueueCell *)malloc(size * sizeof(CQueueCell));
+    if (!q->cells)
+        return -1;
+
+    // Ячейка i свободна для записи номер i
+    for (size_t i = 0; i < size; i++)
+        atomic_init(&q->cells[i].sequence, i);
+    q->mask = size - 1;
+    atomic_init(&q->enqueue_pos, 0);
+    atomic_init(&q->dequeue_pos, 0);
+    return 0;
+}
+
+void cqueue_free(CQueue *q)
+{
+    free(q->cells);
+    q->cells = NULL;
+    q->mask = 0;
+}
+
+// Запись номер pos занимает ячейку, когда ее sequence == pos;
+// после записи sequence становится pos + 1 (ячейку можно читать)
+int cqueue_try_push(CQueue *q, int value)
+{
+    size_t pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+    for (;;) {
+        CQueueCell *cell = &q->cells[pos & q->mask];
+        size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                cell->value = value;
+                atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+                return 0;
+            }
+        } else if (diff < 0) {
+            return -1;  // Ячейку еще не освободил потребитель прошлого круга
+        } else {
+            pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+// Чтение номер pos ждет sequence == pos + 1, после чтения ячейка
+// освобождается для записи следующего круга (pos + емкость)
+int cqueue_try_pop(CQueue *q, int *value)
+{
+    size_t pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+    for (;;) {
+        CQueueCell *cell = &q->cells[pos & q->mask];
+        size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->dequeue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                if (value)
+                    *value = cell->value;
+                atomic_store_explicit(&cell->sequence, pos + q->mask + 1,
+                                      memory_order_release);
+                return 0;
+            }
+        } else if (diff < 0) {
+            return -1;  // Очередь пуста
+        } else {
+            pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+void cqueue_push(CQueue *q, int value)
+{
+    unsigned spins = 0;
+    while (cqueue_try_push(q, value) != 0)
+        cqueue_backoff(&spins);
+}
+
+void cqueue_pop(CQueue *q, int *value)
+{
+    unsigned spins = 0;
+    while (cqueue_try_pop(q, value) != 0)
+        cqueue_backoff(&spins);
+}
+
+// Пакетная запись: находим, сколько ячеек подряд готово к записи,
+// и занимаем их все одним сравнением-обменом enqueue_pos
+size_t cqueue_try_push_n(CQueue *q, const int *values, size_t n)
+{
+    size_t pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+    for (;;) {
+        size_t ready = 0;
+        while (ready < n && ready <= q->mask) {
+            CQueueCell *cell = &q->cells[(pos + ready) & q->mask];
+            if (atomic_load_explicit(&cell->sequence, memory_order_acquire) != pos + ready)
+                break;
+            ready++;
+        }
+
+        if (ready == 0) {
+            size_t seq = atomic_load_explicit(&q->cells[pos & q->mask].sequence,
+                                              memory_order_acquire);
+            if ((intptr_t)seq - (intptr_t)pos < 0)
+                return 0;
+            pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+            continue;
+        }
+
+        if (atomic_compare_exchange_weak_explicit(&q->enqueue_pos, &pos, pos + ready,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+            for (size_t i = 0; i < ready; i++) {
+                CQueueCell *cell = &q->cells[(pos + i) & q->mask];
+                cell->value = values[i];
+                atomic_store_explicit(&cell->sequence, pos + i + 1, memory_order_release);
+            }
+            return ready;
+        }
+    }
+}
+
+size_t cqueue_try_pop_n(CQueue *q, int *out, size_t n)
+{
+    size_t pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+    for (;;) {
+        size_t ready = 0;
+        while (ready < n && ready <= q->mask) {
+            CQueueCell *cell = &q->cells[(pos + ready) & q->mask];
+            if (atomic_load_explicit(&cell->sequence, memory_order_acquire) != pos + ready + 1)
+                break;
+            ready++;
+        }
+
+        if (ready == 0) {
+            size_t seq = atomic_load_explicit(&q->cells[pos & q->mask].sequence,
+                                              memory_order_acquire);
+            if ((intptr_t)seq - (intptr_t)(pos + 1) < 0)
+                return 0;
+            pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+            continue;
+        }
+
+        if (atomic_compare_exchange_weak_explicit(&q->dequeue_pos, &pos, pos + ready,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+            for (size_t i = 0; i < ready; i++) {
+                CQueueCell *cell = &q->cells[(pos + i) & q->mask];
+                out[i] = cell->value;
+                atomic_store_explicit(&cell->sequence, pos + i + q->mask + 1,
+                                      memory_order_release);
+            }
+            return ready;
+        }
+    }
+}
+
+/* ==================== SPSC ==================== */
+
+int cqueue_spsc_init(CQueueSpsc *q, size_t capacity)
+{
+    size_t size = round_up_pow2(capacity);
+    q->data = (int *)malloc(size * sizeof(int));
+    if (!q->data)
+        return -1;
+
+    q->mask = size - 1;
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    q->cached_head = q->cached_tail = 0;
+    return 0;
+}
+
+void cqueue_spsc_free(CQueueSpsc *q)
+{
+    free(q->data);
+    q->data = NULL;
+    q->mask = 0;
+}
+
+int cqueue_spsc_try_push(CQueueSpsc *q, int value)
+{
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    if (tail - q->cached_head > q->mask) {
+        q->cached_head = atomic_load_explicit(&q->head, memory_order_acquire);
+        if (tail - q->cached_head > q->mask)
+            return -1;
+    }
+
+    q->data[tail & q->mask] = value;
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    return 0;
+}
+
+int cqueue_spsc_try_pop(CQueueSpsc *q, int *value)
+{
+    size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    if (head == q->cached_tail) {
+        q->cached_tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+        if (head == q->cached_tail)
+            return -1;
+    }
+
+    if (value)
+        *value = q->data[head & q->mask];
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    return 0;
+}
+
+void cqueue_spsc_push(CQueueSpsc *q, int value)
+{
+    unsigned spins = 0;
+    while (cqueue_spsc_try_push(q, value) != 0)
+        cqueue_backoff(&spins);
+}
+
+void cqueue_spsc_pop(CQueueSpsc *q, int *value)
+{
+    unsigned spins = 0;
+    while (cqueue_spsc_try_pop(q, value) != 0)
+        cqueue_backoff(&spins);
+}
+
+// Пакетная запись: не больше свободного места, копирование двумя кусками
+size_t cqueue_spsc_try_push_n(CQueueSpsc *q, const int *values, size_t n)
+{
+    size_t capacity = q->mask + 1;
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    size_t free_slots = capacity - (tail - q->cached_head);
+    if (free_slots < n) {
+        q->cached_head = atomic_load_explicit(&q->head, memory_order_acquire);
+        free_slots = capacity - (tail - q->cached_head);
+    }
+    if (n > free_slots)
+        n = free_slots;
+    if (n == 0)
+        return 0;
+
+    size_t start = tail & q->mask;
+    size_t first = capacity - start < n ? capacity - start : n;
+    memcpy(q->data + start, values, first * sizeof(int));
+    memcpy(q->data, values + first, (n - first) * sizeof(int));
+    atomic_store_explicit(&q->tail, tail + n, memory_order_release);
+    return n;
+}
+
+size_t cqueue_spsc_try_pop_n(CQueueSpsc *q, int *out, size_t n)
+{
+    size_t capacity = q->mask + 1;
+    size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    size_t available = q->cached_tail - head;
+    if (available < n) {
+        q->cached_tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+        available = q->cached_tail - head;
+    }
+    if (n > available)
+        n = available;
+    if (n == 0)
+        return 0;
+
+    size_t start = head & q->mask;
+    size_t first = capacity - start < n ? capacity - start : n;
+    memcpy(out, q->data + start, first * sizeof(int));
+    memcpy(out + first, q->data, (n - first) * sizeof(int));
+    atomic_store_explicit(&q->head, head + n, memory_order_release);
+    return n;
+}
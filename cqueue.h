@@ -0,0 +1,73 @@
+#ifndef CQUEUE_H
+#define CQUEUE_H
+
+#include <stddef.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+
+//КОНКУРЕНТНЫЕ ОЧЕРЕДИ (без блокировок)
+//Ограниченные кольцевые буферы int для обмена между потоками.
+//CQueue - много производителей и много потребителей (MPMC),
+//у каждой ячейки свой счетчик-последовательность (схема Вьюкова).
+//CQueueSpsc - один производитель и один потребитель, только два индекса.
+//Функции try_* не ждут и возвращают -1, если очередь полна/пуста;
+//push/pop без try ждут, уступая процессор другим потокам.
+
+#define CQUEUE_CACHE_LINE 64
+
+//ЯЧЕЙКА MPMC-ОЧЕРЕДИ
+typedef struct CQueueCell {
+    atomic_size_t sequence;       // Номер операции, которая может занять ячейку
+    int value;                    // Хранимое значение
+} CQueueCell;
+
+//MPMC-ОЧЕРЕДЬ
+typedef struct CQueue {
+    CQueueCell *cells;            // Кольцевой буфер ячеек
+    size_t mask;                  // Емкость - 1 (емкость - степень двойки)
+    alignas(CQUEUE_CACHE_LINE) atomic_size_t enqueue_pos;  // Следующая запись
+    alignas(CQUEUE_CACHE_LINE) atomic_size_t dequeue_pos;  // Следующее чтение
+} CQueue;
+
+//SPSC-ОЧЕРЕДЬ
+//Каждая сторона помнит последний увиденный индекс другой стороны
+//и перечитывает его только когда очередь кажется полной/пустой
+typedef struct CQueueSpsc {
+    int *data;                    // Кольцевой буфер значений
+    size_t mask;                  // Емкость - 1
+    alignas(CQUEUE_CACHE_LINE) atomic_size_t head;         // Читает потребитель
+    size_t cached_tail;                                    // Копия tail у потребителя
+    alignas(CQUEUE_CACHE_LINE) atomic_size_t tail;         // Пишет производитель
+    size_t cached_head;                                    // Копия head у производителя
+} CQueueSpsc;
+
+/* ==================== MPMC ==================== */
+
+//Инициализация (емкость округляется вверх до степени двойки); 0 - успех
+int cqueue_init(CQueue *q, size_t capacity);
+void cqueue_free(CQueue *q);
+
+int cqueue_try_push(CQueue *q, int value);
+int cqueue_try_pop(CQueue *q, int *value);
+void cqueue_push(CQueue *q, int value);
+void cqueue_pop(CQueue *q, int *value);
+
+//Пакетные операции: занимают подряд идущие ячейки одной атомарной
+//операцией; возвращают, сколько значений удалось добавить/извлечь
+size_t cqueue_try_push_n(CQueue *q, const int *values, size_t n);
+size_t cqueue_try_pop_n(CQueue *q, int *out, size_t n);
+
+/* ==================== SPSC ==================== */
+
+int cqueue_spsc_init(CQueueSpsc *q, size_t capacity);
+void cqueue_spsc_free(CQueueSpsc *q);
+
+int cqueue_spsc_try_push(CQueueSpsc *q, int value);
+int cqueue_spsc_try_pop(CQueueSpsc *q, int *value);
+void cqueue_spsc_push(CQueueSpsc *q, int value);
+void cqueue_spsc_pop(CQueueSpsc *q, int *value);
+
+size_t cqueue_spsc_try_push_n(CQueueSpsc *q, const int *values, size_t n);
+size_t cqueue_spsc_try_pop_n(CQueueSpsc *q, int *out, size_t n);
+
+#endif /* CQUEUE_H */
@@ -0,0 +1,366 @@
+#include "external_sort.h"
+#include "fast_io.h"
+#include "simd_sort.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Меньше этого серии и буферы слияния не делаются
+#define EXTERNAL_MIN_RUN    (64 * 1024)
+#define EXTERNAL_MIN_BUFFER 1024
+
+// Серия во временном файле (сырые int)
+typedef struct RunFile {
+    FILE *file;
+    size_t count;
+} RunFile;
+
+// Список серий
+typedef struct RunList {
+    RunFile *items;
+    size_t count;
+    size_t capacity;
+} RunList;
+
+// Состояние первой фазы: накопление серии
+typedef struct RunBuilder {
+    int *data;
+    size_t size;
+    size_t capacity;
+    RunList *runs;
+    size_t total;
+    int verbose;
+} RunBuilder;
+
+// Источник слияния: серия с буфером чтения
+typedef struct RunReader {
+    FILE *file;
+    int *buf;
+    size_t len;
+    size_t pos;
+    size_t remaining;           // Еще не прочитано из файла
+} RunReader;
+
+// Куда идет результат слияния: в новую серию или в итоговый текст
+typedef struct MergeTarget {
+    FILE *run;
+    IntWriter *text;
+} MergeTarget;
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int run_list_add(RunList *list, FILE *file, size_t count)
+{
+    if (list->count == list->capacity) {
+        size_t new_cap = list->capacity ? list->capacity * 2 : 16;
+        RunFile *tmp = (RunFile *)realloc(list->items, new_cap * sizeof(RunFile));
+        if (!tmp)
+            return -1;
+        list->items = tmp;
+        list->capacity = new_cap;
+    }
+    list->items[list->count].file = file;
+    list->items[list->count].count = count;
+    list->count++;
+    return 0;
+}
+
+static void run_list_free(RunList *list)
+{
+    for (size_t i = 0; i < list->count; i++) {
+        if (list->items[i].file)
+            fclose(list->items[i].file);
+    }
+    free(list->items);
+    list->items = NULL;
+    list->count = list->capacity = 0;
+}
+
+/* ==================== ФАЗА 1: СЕРИИ ==================== */
+
+// Сортировка накопленной серии и запись во временный файл
+static int builder_spill(RunBuilder *b)
+{
+    if (b->size == 0)
+        return 0;
+
+    simd_sort_ints(b->data, b->size);
+
+    FILE *f = tmpfile();
+    if (!f)
+        return -1;
+    if (fwrite(b->data, sizeof(int), b->size, f) != b->size ||
+        fflush(f) != 0 || run_list_add(b->runs, f, b->size) != 0) {
+        fclose(f);
+        return -1;
+    }
+    rewind(f);
+
+    if (b->verbose)
+        printf("Серия %zu: %zu чисел (всего прочитано %zu)\n",
+               b->runs->count, b->size, b->total);
+    b->size = 0;
+    return 0;
+}
+
+// Получатель чисел от потокового разбора входа
+static int builder_sink(void *ctx, const int *values, size_t n)
+{
+    RunBuilder *b = (RunBuilder *)ctx;
+    while (n > 0) {
+        size_t part = b->capacity - b->size;
+        if (part > n)
+            part = n;
+        memcpy(b->data + b->size, values, part * sizeof(int));
+        b->size += part;
+        b->total += part;
+        values += part;
+        n -= part;
+        if (b->size == b->capacity && builder_spill(b) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+/* ==================== ФАЗА 2: СЛИЯНИЕ ==================== */
+
+static int reader_fill(RunReader *r, size_t buffer_len)
+{
+    size_t want = r->remaining < buffer_len ? r->remaining : buffer_len;
+    r->len = fread(r->buf, sizeof(int), want, r->file);
+    r->pos = 0;
+    r->remaining -= r->len;
+    return r->len == want ? 0 : -1;
+}
+
+// Просеивание вниз в min-куче источников по их текущему значению
+static void heap_sift_down(RunReader **heap, size_t count, size_t i)
+{
+    for (;;) {
+        size_t smallest = i;
+        size_t left = 2 * i + 1, right = 2 * i + 2;
+        if (left < count &&
+            heap[left]->buf[heap[left]->pos] < heap[smallest]->buf[heap[smallest]->pos])
+            smallest = left;
+        if (right < count &&
+            heap[right]->buf[heap[right]->pos] < heap[smallest]->buf[heap[smallest]->pos])
+            smallest = right;
+        if (smallest == i)
+            return;
+        RunReader *tmp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = tmp;
+        i = smallest;
+    }
+}
+
+// Выдача слитого буфера в новую серию или в итоговый текст
+static int target_write(MergeTarget *target, const int *values, size_t n)
+{
+    if (target->run)
+        return fwrite(values, sizeof(int), n, target->run) == n ? 0 : -1;
+    int_writer_ints(target->text, values, n);
+    return 0;
+}
+
+// Слияние k серий в target через min-кучу источников
+// storage - (k + 1) буферов по buffer_len: k для чтения и один для вывода
+static int merge_loop(RunFile *runs, size_t k, MergeTarget *target, int *storage,
+                      size_t buffer_len, RunReader *readers, RunReader **heap,
+                      size_t progress_total, int verbose)
+{
+    int *out = storage + k * buffer_len;
+    size_t out_len = 0, heap_count = 0;
+
+    for (size_t i = 0; i < k; i++) {
+        readers[i].file = runs[i].file;
+        readers[i].buf = storage + i * buffer_len;
+        readers[i].remaining = runs[i].count;
+        if (reader_fill(&readers[i], buffer_len) != 0)
+            return -1;
+        if (readers[i].len > 0)
+            heap[heap_count++] = &readers[i];
+    }
+    for (size_t i = heap_count / 2; i-- > 0;)
+        heap_sift_down(heap, heap_count, i);
+
+    size_t written = 0, next_report = progress_total / 10;
+    while (heap_count > 0) {
+        RunReader *r = heap[0];
+        out[out_len++] = r->buf[r->pos++];
+
+        // Буфер источника кончился: дочитываем или убираем источник из кучи
+        if (r->pos == r->len) {
+            if (r->remaining > 0 && reader_fill(r, buffer_len) != 0)
+                return -1;
+            if (r->pos == r->len)
+                heap[0] = heap[--heap_count];
+        }
+        if (heap_count > 0)
+            heap_sift_down(heap, heap_count, 0);
+
+        if (out_len == buffer_len || heap_count == 0) {
+            if (target_write(target, out, out_len) != 0)
+                return -1;
+            written += out_len;
+            out_len = 0;
+            if (verbose && progress_total > 0 && written >= next_report) {
+                printf("Слияние: %zu%%\n", written * 100 / progress_total);
+                next_report = written + progress_total / 10;
+            }
+        }
+    }
+    return 0;
+}
+
+// Слияние k серий; память делится поровну между источниками и выходом
+// progress_total - общее число значений для процентов хода работы
+static int merge_runs(RunFile *runs, size_t k, MergeTarget *target,
+                      size_t memory_ints, size_t progress_total, int verbose)
+{
+    size_t buffer_len = memory_ints / (k + 1);
+    if (buffer_len < EXTERNAL_MIN_BUFFER)
+        buffer_len = EXTERNAL_MIN_BUFFER;
+
+    RunReader *readers = (RunReader *)calloc(k, sizeof(RunReader));
+    RunReader **heap = (RunReader **)malloc(k * sizeof(RunReader *));
+    int *storage = (int *)malloc((k + 1) * buffer_len * sizeof(int));
+
+    int status = -1;
+    if (readers && heap && storage)
+        status = merge_loop(runs, k, target, storage, buffer_len, readers, heap,
+                            progress_total, verbose);
+
+    free(readers);
+    free(heap);
+    free(storage);
+    return status;
+}
+
+// Проходы слияния групп по EXTERNAL_MAX_FANIN, пока серий не станет мало
+static int merge_passes(RunList *runs, size_t memory_ints, int verbose, int *passes)
+{
+    while (runs->count > EXTERNAL_MAX_FANIN) {
+        RunList next = { NULL, 0, 0 };
+        (*passes)++;
+        if (verbose)
+            printf("Промежуточный проход слияния: %zu серий\n", runs->count);
+
+        for (size_t i = 0; i < runs->count; i += EXTERNAL_MAX_FANIN) {
+            size_t k = runs->count - i < EXTERNAL_MAX_FANIN ? runs->count - i : EXTERNAL_MAX_FANIN;
+            size_t count = 0;
+            for (size_t j = 0; j < k; j++)
+                count += runs->items[i + j].count;
+
+            MergeTarget target = { tmpfile(), NULL };
+            if (!target.run || merge_runs(runs->items + i, k, &target, memory_ints, 0, 0) != 0 ||
+                fflush(target.run) != 0 || run_list_add(&next, target.run, count) != 0) {
+                if (target.run)
+                    fclose(target.run);
+                run_list_free(&next);
+                return -1;
+            }
+            rewind(target.run);
+
+            // Слитые серии больше не нужны: временные файлы удаляются при закрытии
+            for (size_t j = 0; j < k; j++) {
+                fclose(runs->items[i + j].file);
+                runs->items[i + j].file = NULL;
+            }
+        }
+
+        run_list_free(runs);
+        *runs = next;
+    }
+    return 0;
+}
+
+int external_sort_file(const char *input, const char *output,
+                       size_t memory_bytes, int verbose, ExternalSortStats *stats)
+{
+    ExternalSortStats local_stats;
+    if (!stats)
+        stats = &local_stats;
+    memset(stats, 0, sizeof(*stats));
+    double start = now_seconds();
+
+    if (memory_bytes == 0)
+        memory_bytes = (size_t)EXTERNAL_DEFAULT_MEMORY_MB * 1024 * 1024;
+    size_t memory_ints = memory_bytes / sizeof(int);
+
+    // Векторной сортировке нужен еще двойной буфер: серия - треть бюджета
+    size_t run_capacity = memory_ints / 3;
+    if (run_capacity < EXTERNAL_MIN_RUN)
+        run_capacity = EXTERNAL_MIN_RUN;
+
+    FILE *in = fopen(input, "r");
+    if (!in)
+        return EXTERNAL_ERR_INPUT;
+
+    RunList runs = { NULL, 0, 0 };
+    RunBuilder builder = { NULL, 0, run_capacity, &runs, 0, verbose };
+    builder.data = (int *)malloc(run_capacity * sizeof(int));
+    if (!builder.data) {
+        fclose(in);
+        return EXTERNAL_ERR_TEMP;
+    }
+
+    int status = 0;
+    int read_status = read_ints_stream(in, builder_sink, &builder, &stats->parse);
+    if (read_status != 0)
+        status = ferror(in) ? EXTERNAL_ERR_INPUT : EXTERNAL_ERR_TEMP;
+    fclose(in);
+    stats->values = builder.total;
+
+    IntWriter writer;
+    FILE *out = NULL;
+    if (status == 0) {
+        out = fopen(output, "w");
+        if (out)
+            int_writer_init(&writer, out);
+        else
+            status = EXTERNAL_ERR_OUTPUT;
+    }
+
+    if (status == 0 && runs.count == 0) {
+        // Все поместилось в одну серию: временные файлы не нужны
+        simd_sort_ints(builder.data, builder.size);
+        int_writer_ints(&writer, builder.data, builder.size);
+    } else if (status == 0) {
+        if (builder_spill(&builder) != 0)
+            status = EXTERNAL_ERR_TEMP;
+        // Буфер серии больше не нужен: вся память идет под слияние
+        free(builder.data);
+        builder.data = NULL;
+        stats->runs = runs.count;
+
+        if (status == 0 && merge_passes(&runs, memory_ints, verbose, &stats->merge_passes) != 0)
+            status = EXTERNAL_ERR_TEMP;
+        if (status == 0) {
+            MergeTarget target = { NULL, &writer };
+            stats->merge_passes++;
+            if (merge_runs(runs.items, runs.count, &target, memory_ints,
+                           stats->values, verbose) != 0)
+                status = EXTERNAL_ERR_TEMP;
+        }
+    }
+
+    if (out) {
+        int_writer_newline(&writer);
+        if (int_writer_flush(&writer) != 0 && status == 0)
+            status = EXTERNAL_ERR_OUTPUT;
+        if (fclose(out) != 0 && status == 0)
+            status = EXTERNAL_ERR_OUTPUT;
+    }
+
+    free(builder.data);
+    run_list_free(&runs);
+    stats->seconds = now_seconds() - start;
+    return status;
+}
@@ -0,0 +1,36 @@
+#ifndef EXTERNAL_SORT_H
+#define EXTERNAL_SORT_H
+
+#include <stddef.h>
+#include "number_io.h"
+
+//ВНЕШНЯЯ СОРТИРОВКА (для файлов больше оперативной памяти)
+//Вход читается потоком и режется на серии в пределах бюджета памяти,
+//каждая серия сортируется в памяти и сбрасывается во временный файл,
+//затем серии сливаются k-путевым слиянием через буферы чтения.
+//Если серий больше EXTERNAL_MAX_FANIN, слияние идет в несколько проходов.
+
+#define EXTERNAL_DEFAULT_MEMORY_MB 256
+#define EXTERNAL_MAX_FANIN 128
+
+//Итоги внешней сортировки
+typedef struct ExternalSortStats {
+    size_t values;              // Отсортировано чисел
+    size_t runs;                // Серий во временных файлах
+    int merge_passes;           // Проходов слияния
+    NumberParseStats parse;     // Пропущенные при чтении лексемы
+    double seconds;             // Общее время
+} ExternalSortStats;
+
+//Коды ошибок external_sort_file
+#define EXTERNAL_ERR_INPUT  -1  // Не удалось открыть или прочитать вход
+#define EXTERNAL_ERR_OUTPUT -2  // Не удалось записать результат
+#define EXTERNAL_ERR_TEMP   -3  // Нет памяти или временных файлов
+
+//Сортировка чисел из текстового файла input в одну строку файла output
+//memory_bytes - бюджет памяти (0 - EXTERNAL_DEFAULT_MEMORY_MB);
+//verbose - печатать ход работы; stats может быть NULL. 0 - успех
+int external_sort_file(const char *input, const char *output,
+                       size_t memory_bytes, int verbose, ExternalSortStats *stats);
+
+#endif /* EXTERNAL_SORT_H */
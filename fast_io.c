@@ -0,0 +1,83 @@
+#include "fast_io.h"
+#include <string.h>
+
+// Самая длинная запись: пробел и "-2147483648"
+#define INT_TEXT_MAX 12
+
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Цифры пишутся с конца по две за шаг, затем копируются в начало out
+size_t format_int(char *out, int value)
+{
+    char tmp[INT_TEXT_MAX];
+    char *p = tmp + sizeof(tmp);
+    unsigned u = value < 0 ? 0u - (unsigned)value : (unsigned)value;
+
+    while (u >= 100) {
+        unsigned pair = (u % 100) * 2;
+        u /= 100;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    }
+    if (u >= 10) {
+        *--p = digit_pairs[u * 2 + 1];
+        *--p = digit_pairs[u * 2];
+    } else {
+        *--p = (char)('0' + u);
+    }
+    if (value < 0)
+        *--p = '-';
+
+    size_t len = (size_t)(tmp + sizeof(tmp) - p);
+    memcpy(out, p, len);
+    return len;
+}
+
+void int_writer_init(IntWriter *w, FILE *stream)
+{
+    w->stream = stream;
+    w->used = 0;
+    w->line_items = 0;
+    w->error = 0;
+}
+
+int int_writer_flush(IntWriter *w)
+{
+    if (w->used > 0 && fwrite(w->buf, 1, w->used, w->stream) != w->used)
+        w->error = 1;
+    w->used = 0;
+    return w->error ? -1 : 0;
+}
+
+void int_writer_int(IntWriter *w, int value)
+{
+    if (w->used > INT_WRITER_BUFFER_SIZE - INT_TEXT_MAX)
+        int_writer_flush(w);
+    if (w->line_items++ > 0)
+        w->buf[w->used++] = ' ';
+    w->used += format_int(w->buf + w->used, value);
+}
+
+void int_writer_ints(IntWriter *w, const int *values, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        int_writer_int(w, values[i]);
+}
+
+void int_writer_newline(IntWriter *w)
+{
+    if (w->used == INT_WRITER_BUFFER_SIZE)
+        int_writer_flush(w);
+    w->buf[w->used++] = '\n';
+    w->line_items = 0;
+}
@@ -0,0 +1,37 @@
+#ifndef FAST_IO_H
+#define FAST_IO_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+//БУФЕРИЗОВАННЫЙ ВЫВОД ЦЕЛЫХ ЧИСЕЛ
+//Числа переводятся в десятичный вид по таблице пар цифр и копятся
+//в собственном буфере; в поток он уходит одним fwrite, когда заполнится.
+//Числа одной строки разделяются пробелом автоматически.
+
+#define INT_WRITER_BUFFER_SIZE 65536
+
+typedef struct IntWriter {
+    FILE *stream;
+    size_t used;                        // Занято байт в буфере
+    size_t line_items;                  // Чисел в текущей строке
+    int error;                          // Была ошибка записи
+    char buf[INT_WRITER_BUFFER_SIZE];
+} IntWriter;
+
+void int_writer_init(IntWriter *w, FILE *stream);
+
+//Число (с пробелом перед ним, если оно не первое в строке)
+void int_writer_int(IntWriter *w, int value);
+//Ряд чисел через пробел
+void int_writer_ints(IntWriter *w, const int *values, size_t n);
+//Перевод строки
+void int_writer_newline(IntWriter *w);
+
+//Сброс буфера в поток; 0 - успех, -1 - была ошибка записи
+int int_writer_flush(IntWriter *w);
+
+//Десятичная запись value в out (не меньше 11 байт); возвращает длину
+size_t format_int(char *out, int value);
+
+#endif /* FAST_IO_H */
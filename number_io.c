@@ -1,119 +1,819 @@
 #include "number_io.h"
+#include "fast_io.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-#define LINE_BUFFER_SIZE 4096
+#define READ_BLOCK_SIZE  65536   /* строка читается кусками такого размера */
+#define PARSE_BATCH      1024    /* числа отдаются получателю пачками */
+#define TOKEN_MAX        64      /* длиннее - заведомо не int */
 #define INITIAL_CAPACITY 16
 
-/* чтение одной строки чисел из любого потока */
-static size_t read_ints_from_stream(FILE *stream, int **out_data)
+typedef enum TokenStatus {
+    TOKEN_OK = 0,
+    TOKEN_OVERFLOW,
+    TOKEN_INVALID
+} TokenStatus;
+
+/* состояние разбора одной строки */
+typedef struct LineParser {
+    char   carry[TOKEN_MAX];      /* начало числа, разрезанного границей куска */
+    size_t carry_len;
+    int    carry_too_long;
+    int    batch[PARSE_BATCH];
+    size_t batch_len;
+    IntSink sink;
+    void   *ctx;
+    NumberParseStats *stats;
+    int    failed;                /* получатель вернул ошибку */
+} LineParser;
+
+static int is_space(char c)
 {
-    char buffer[LINE_BUFFER_SIZE];
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
 
-    if (!fgets(buffer, sizeof(buffer), stream)) {
-        *out_data = NULL;
-        return 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+/* 8 байт подряд - все цифры (SWAR: проверка всех байт одним словом) */
+static int all_digits8(uint64_t chunk)
+{
+    return (chunk & 0xF0F0F0F0F0F0F0F0ull) == 0x3030303030303030ull &&
+           ((chunk + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) == 0x3030303030303030ull;
+}
+
+/* значение 8 цифр: пары, четверки, восьмерка за три умножения */
+static uint32_t parse_digits8(uint64_t chunk)
+{
+    chunk -= 0x3030303030303030ull;
+    chunk = (chunk * 10 + (chunk >> 8)) & 0x00FF00FF00FF00FFull;
+    chunk = (chunk * 100 + (chunk >> 16)) & 0x0000FFFF0000FFFFull;
+    return (uint32_t)((chunk * 10000 + (chunk >> 32)) & 0xFFFFFFFFull);
+}
+#define HAVE_SWAR_DIGITS 1
+#endif
+
+/* разбор одной лексемы вида [+-]цифры в int */
+static TokenStatus parse_token(const char *s, size_t len, int *value)
+{
+    size_t i = 0;
+    int negative = 0;
+    if (len > 0 && (s[0] == '-' || s[0] == '+')) {
+        negative = s[0] == '-';
+        i = 1;
     }
+    if (i == len)
+        return TOKEN_INVALID;
 
-    int   *data     = NULL;
-    size_t size     = 0;
-    size_t capacity = 0;
+    /* накопитель не переполняется: пока он <= limit, acc * 10^8 < 2^64 */
+    const uint64_t limit = negative ? (uint64_t)INT_MAX + 1 : (uint64_t)INT_MAX;
+    uint64_t acc = 0;
+    int overflow = 0;
 
-    char *token = strtok(buffer, " \t\r\n");
-    while (token) {
-        if (size == capacity) {
-            size_t new_cap = capacity ? capacity * 2 : INITIAL_CAPACITY;
-            int *tmp = (int *)realloc(data, new_cap * sizeof(int));
-            if (!tmp) {
-                free(data);
-                *out_data = NULL;
-                return 0;
-            }
-            data     = tmp;
-            capacity = new_cap;
+#ifdef HAVE_SWAR_DIGITS
+    while (len - i >= 8) {
+        uint64_t chunk;
+        memcpy(&chunk, s + i, 8);
+        if (!all_digits8(chunk))
+            break;
+        if (!overflow) {
+            acc = acc * 100000000u + parse_digits8(chunk);
+            overflow = acc > limit;
+        }
+        i += 8;
+    }
+#endif
+    for (; i < len; i++) {
+        unsigned d = (unsigned char)s[i] - '0';
+        if (d > 9)
+            return TOKEN_INVALID;
+        if (!overflow) {
+            acc = acc * 10 + d;
+            overflow = acc > limit;
         }
+    }
+    if (overflow)
+        return TOKEN_OVERFLOW;
+
+    *value = negative ? (int)-(int64_t)acc : (int)acc;
+    return TOKEN_OK;
+}
+
+static void parser_flush(LineParser *p)
+{
+    if (p->batch_len > 0 && !p->failed && p->sink(p->ctx, p->batch, p->batch_len) != 0)
+        p->failed = 1;
+    p->batch_len = 0;
+}
+
+static void parser_token(LineParser *p, const char *s, size_t len)
+{
+    int value;
+    switch (parse_token(s, len, &value)) {
+    case TOKEN_OK:
+        p->batch[p->batch_len++] = value;
+        p->stats->parsed++;
+        if (p->batch_len == PARSE_BATCH)
+            parser_flush(p);
+        break;
+    case TOKEN_OVERFLOW:
+        p->stats->overflow++;
+        break;
+    default:
+        p->stats->invalid++;
+        break;
+    }
+}
+
+/* лексема, не поместившаяся в TOKEN_MAX: число вне диапазона или мусор */
+static void parser_long_token(LineParser *p)
+{
+    size_t i = (p->carry[0] == '-' || p->carry[0] == '+');
+    while (i < p->carry_len && p->carry[i] >= '0' && p->carry[i] <= '9')
+        i++;
+    if (i == p->carry_len && p->carry_len > 1)
+        p->stats->overflow++;
+    else
+        p->stats->invalid++;
+}
+
+static void parser_finish_carry(LineParser *p)
+{
+    if (p->carry_too_long)
+        parser_long_token(p);
+    else if (p->carry_len > 0)
+        parser_token(p, p->carry, p->carry_len);
+    p->carry_len = 0;
+    p->carry_too_long = 0;
+}
+
+/* дописывает к переносу символы, при переполнении лексема помечается длинной */
+static void parser_append_carry(LineParser *p, const char *s, size_t len)
+{
+    if (p->carry_too_long)
+        return;
+    if (p->carry_len + len > TOKEN_MAX) {
+        len = TOKEN_MAX - p->carry_len;
+        p->carry_too_long = 1;
+    }
+    memcpy(p->carry + p->carry_len, s, len);
+    p->carry_len += len;
+}
+
+/* разбор куска; лексема у правого края без пробела переносится в следующий */
+static void parser_block(LineParser *p, const char *s, size_t len, int line_done)
+{
+    size_t i = 0;
+
+    if (p->carry_len > 0 || p->carry_too_long) {
+        while (i < len && !is_space(s[i]))
+            i++;
+        parser_append_carry(p, s, i);
+        if (i < len || line_done)
+            parser_finish_carry(p);
+    }
+
+    while (i < len) {
+        while (i < len && is_space(s[i]))
+            i++;
+        size_t start = i;
+        while (i < len && !is_space(s[i]))
+            i++;
+        if (start == i)
+            break;
+        if (i == len && !line_done)
+            parser_append_carry(p, s + start, i - start);
+        else
+            parser_token(p, s + start, i - start);
+    }
+}
+
+static void parser_init(LineParser *p, IntSink sink, void *ctx, NumberParseStats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    p->carry_len = 0;
+    p->carry_too_long = 0;
+    p->batch_len = 0;
+    p->sink = sink;
+    p->ctx = ctx;
+    p->stats = stats;
+    p->failed = 0;
+}
+
+/*
+ * Чтение одной строки любой длины: fgets кусками по READ_BLOCK_SIZE
+ * (не заходит за перевод строки, поэтому следующие строки и ввод
+ * scanf остаются в потоке). Возвращает 1 - строка прочитана,
+ * 0 - конец файла, -1 - ошибка памяти или получателя.
+ */
+static int parse_line(FILE *stream, IntSink sink, void *ctx, NumberParseStats *stats)
+{
+    NumberParseStats local_stats;
+    if (!stats)
+        stats = &local_stats;
+
+    char *block = (char *)malloc(READ_BLOCK_SIZE);
+    if (!block)
+        return -1;
+    LineParser p;
+    parser_init(&p, sink, ctx, stats);
+
+    int got_line = 0;
+    while (fgets(block, READ_BLOCK_SIZE, stream)) {
+        size_t len = strlen(block);
+        int line_done = len > 0 && block[len - 1] == '\n';
+        got_line = 1;
+        parser_block(&p, block, len, line_done);
+        if (line_done)
+            break;
+    }
+    parser_finish_carry(&p);
+    parser_flush(&p);
+    free(block);
+
+    return p.failed ? -1 : got_line;
+}
+
+/* весь поток до конца файла, переводы строк - обычные разделители */
+int read_ints_stream(FILE *stream, IntSink sink, void *ctx, NumberParseStats *stats)
+{
+    NumberParseStats local_stats;
+    if (!stats)
+        stats = &local_stats;
+
+    char *block = (char *)malloc(READ_BLOCK_SIZE);
+    if (!block)
+        return -1;
+    LineParser p;
+    parser_init(&p, sink, ctx, stats);
+
+    size_t len;
+    while (!p.failed && (len = fread(block, 1, READ_BLOCK_SIZE, stream)) > 0)
+        parser_block(&p, block, len, 0);
+    parser_finish_carry(&p);
+    parser_flush(&p);
+    free(block);
 
-        data[size++] = atoi(token);
-        token = strtok(NULL, " \t\r\n");
+    return p.failed || ferror(stream) ? -1 : 0;
+}
+
+/* разбор уже находящегося в памяти текста (например, отображенного файла) */
+static int parse_memory(const char *s, size_t len, IntSink sink, void *ctx,
+                        NumberParseStats *stats)
+{
+    NumberParseStats local_stats;
+    if (!stats)
+        stats = &local_stats;
+
+    LineParser p;
+    parser_init(&p, sink, ctx, stats);
+    parser_block(&p, s, len, 1);
+    parser_flush(&p);
+    return p.failed ? -1 : 0;
+}
+
+/* получатель: растущий массив */
+typedef struct IntArray {
+    int   *data;
+    size_t size;
+    size_t capacity;
+} IntArray;
+
+static int array_sink(void *ctx, const int *values, size_t n)
+{
+    IntArray *arr = (IntArray *)ctx;
+    if (arr->size + n > arr->capacity) {
+        size_t new_cap = arr->capacity ? arr->capacity : INITIAL_CAPACITY;
+        while (new_cap < arr->size + n)
+            new_cap *= 2;
+        int *tmp = (int *)realloc(arr->data, new_cap * sizeof(int));
+        if (!tmp)
+            return -1;
+        arr->data     = tmp;
+        arr->capacity = new_cap;
     }
+    memcpy(arr->data + arr->size, values, n * sizeof(int));
+    arr->size += n;
+    return 0;
+}
 
-    *out_data = data;
-    return size;
+/* получатель: очередь */
+static int queue_sink(void *ctx, const int *values, size_t n)
+{
+    return queue_push_n((Queue *)ctx, values, n);
+}
+
+int read_ints_stream_to_queue(FILE *stream, Queue *q, NumberParseStats *stats)
+{
+    return read_ints_stream(stream, queue_sink, q, stats);
+}
+
+size_t read_ints_line(FILE *stream, int **out_data, NumberParseStats *stats)
+{
+    IntArray arr = { NULL, 0, 0 };
+
+    if (parse_line(stream, array_sink, &arr, stats) != 1) {
+        free(arr.data);
+        *out_data = NULL;
+        return 0;
+    }
+
+    *out_data = arr.data;
+    return arr.size;
+}
+
+int read_ints_line_to_queue(FILE *stream, Queue *q, NumberParseStats *stats)
+{
+    return parse_line(stream, queue_sink, q, stats);
+}
+
+/* сообщение о пропущенных лексемах при вводе с клавиатуры */
+static void report_skipped(const NumberParseStats *stats)
+{
+    if (stats->overflow > 0)
+        printf("Пропущено чисел вне диапазона int: %zu\n", stats->overflow);
+    if (stats->invalid > 0)
+        printf("Пропущено нечисловых значений: %zu\n", stats->invalid);
 }
 
 size_t read_ints_from_stdin(int **out_data)
 {
+    NumberParseStats stats;
     printf("Введите последовательность целых чисел через пробел:\n> ");
-    return read_ints_from_stream(stdin, out_data);
+    size_t count = read_ints_line(stdin, out_data, &stats);
+    report_skipped(&stats);
+    return count;
+}
+
+size_t read_queue_from_stdin(Queue *q)
+{
+    NumberParseStats stats;
+    if (read_ints_line_to_queue(stdin, q, &stats) < 0) {
+        printf("Ошибка: не хватает памяти для очереди.\n");
+        return 0;
+    }
+    report_skipped(&stats);
+    return stats.parsed;
 }
 
 void print_int_array(const int *data, size_t n)
 {
-    for (size_t i = 0; i < n; ++i) {
-        printf("%d", data[i]);
-        if (i + 1 < n)
-            printf(" ");
+    IntWriter w;
+    int_writer_init(&w, stdout);
+    int_writer_ints(&w, data, n);
+    int_writer_newline(&w);
+    int_writer_flush(&w);
+}
+
+/* ==================== ДВОИЧНЫЙ ФОРМАТ ==================== */
+
+/*
+ * Заголовок (все поля little-endian):
+ *   0  "QROW"           сигнатура
+ *   4  u32 версия       ROW_BINARY_VERSION
+ *   8  u64              число элементов исходного ряда
+ *  16  u64              число элементов отсортированного ряда
+ *  24  u64              длина закодированного отсортированного ряда в байтах
+ *  32  u32, u32         контрольные суммы значений обоих рядов
+ * Далее исходный ряд как int32, затем отсортированный: разности соседних
+ * значений в зигзаг-кодировке, записанные varint (1 байт для шагов < 64).
+ */
+#define ROW_BINARY_MAGIC   "QROW"
+#define ROW_BINARY_VERSION 1u
+#define ROW_HEADER_SIZE    40
+#define ENCODE_BLOCK_SIZE  65536
+
+static void put_u32(unsigned char *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static void put_u64(unsigned char *p, uint64_t v)
+{
+    for (int i = 0; i < 8; i++)
+        p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static uint32_t get_u32(const unsigned char *p)
+{
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; i--)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+static uint64_t get_u64(const unsigned char *p)
+{
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+/* контрольная сумма значений (FNV-1a по 32-битным словам) */
+typedef struct RowChecksum {
+    uint64_t h;
+} RowChecksum;
+
+static void checksum_init(RowChecksum *c)
+{
+    c->h = 0xcbf29ce484222325ull;
+}
+
+static void checksum_add(RowChecksum *c, const int *values, size_t n)
+{
+    uint64_t h = c->h;
+    for (size_t i = 0; i < n; i++)
+        h = (h ^ (uint32_t)values[i]) * 0x100000001b3ull;
+    c->h = h;
+}
+
+static uint32_t checksum_value(const RowChecksum *c)
+{
+    return (uint32_t)(c->h ^ (c->h >> 32));
+}
+
+static uint64_t zigzag_delta(int value, int prev)
+{
+    int64_t d = (int64_t)value - prev;
+    return ((uint64_t)d << 1) ^ (uint64_t)(d >> 63);
+}
+
+/* varint: по 7 бит, старший бит - есть продолжение; возвращает длину */
+static size_t varint_put(unsigned char *p, uint64_t v)
+{
+    size_t len = 0;
+    while (v >= 0x80) {
+        p[len++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    p[len++] = (unsigned char)v;
+    return len;
+}
+
+static size_t varint_size(uint64_t v)
+{
+    size_t len = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        len++;
+    }
+    return len;
+}
+
+/* ряд int32 в little-endian; на LE-машинах это прямая запись памяти */
+static int write_raw_row(FILE *f, const int *values, size_t n)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    return fwrite(values, sizeof(int), n, f) == n ? 0 : -1;
+#else
+    unsigned char block[ENCODE_BLOCK_SIZE];
+    size_t used = 0;
+    for (size_t i = 0; i < n; i++) {
+        put_u32(block + used, (uint32_t)values[i]);
+        used += 4;
+        if (used == sizeof(block)) {
+            if (fwrite(block, 1, used, f) != used)
+                return -1;
+            used = 0;
+        }
+    }
+    return fwrite(block, 1, used, f) == used ? 0 : -1;
+#endif
+}
+
+static int write_delta_row(FILE *f, const int *values, size_t n)
+{
+    unsigned char block[ENCODE_BLOCK_SIZE];
+    size_t used = 0;
+    int prev = 0;
+    for (size_t i = 0; i < n; i++) {
+        used += varint_put(block + used, zigzag_delta(values[i], prev));
+        prev = values[i];
+        if (used > sizeof(block) - 10) {
+            if (fwrite(block, 1, used, f) != used)
+                return -1;
+            used = 0;
+        }
+    }
+    return fwrite(block, 1, used, f) == used ? 0 : -1;
+}
+
+static int save_rows_binary(FILE *f,
+                            const int *original, size_t original_n,
+                            const int *sorted,   size_t sorted_n)
+{
+    RowChecksum orig_sum, sorted_sum;
+    checksum_init(&orig_sum);
+    checksum_init(&sorted_sum);
+    checksum_add(&orig_sum, original, original_n);
+    checksum_add(&sorted_sum, sorted, sorted_n);
+
+    /* длина закодированного ряда нужна в заголовке до самих данных */
+    uint64_t sorted_bytes = 0;
+    int prev = 0;
+    for (size_t i = 0; i < sorted_n; i++) {
+        sorted_bytes += varint_size(zigzag_delta(sorted[i], prev));
+        prev = sorted[i];
+    }
+
+    unsigned char header[ROW_HEADER_SIZE];
+    memcpy(header, ROW_BINARY_MAGIC, 4);
+    put_u32(header + 4, ROW_BINARY_VERSION);
+    put_u64(header + 8, original_n);
+    put_u64(header + 16, sorted_n);
+    put_u64(header + 24, sorted_bytes);
+    put_u32(header + 32, checksum_value(&orig_sum));
+    put_u32(header + 36, checksum_value(&sorted_sum));
+
+    if (fwrite(header, 1, sizeof(header), f) != sizeof(header))
+        return -1;
+    if (write_raw_row(f, original, original_n) != 0)
+        return -1;
+    return write_delta_row(f, sorted, sorted_n);
+}
+
+/* разбор заголовка отображенного файла; -1 - файл поврежден */
+static int row_file_parse_header(RowFile *rf)
+{
+    const unsigned char *h = (const unsigned char *)rf->data;
+    if (rf->size < ROW_HEADER_SIZE || get_u32(h + 4) != ROW_BINARY_VERSION)
+        return -1;
+
+    uint64_t original_n = get_u64(h + 8);
+    uint64_t sorted_n = get_u64(h + 16);
+    uint64_t sorted_bytes = get_u64(h + 24);
+    uint64_t payload = rf->size - ROW_HEADER_SIZE;
+    if (original_n > payload / 4 || sorted_bytes > payload - original_n * 4 ||
+        sorted_n > sorted_bytes)
+        return -1;
+
+    rf->count[0] = (size_t)original_n;
+    rf->count[1] = (size_t)sorted_n;
+    rf->checksum[0] = get_u32(h + 32);
+    rf->checksum[1] = get_u32(h + 36);
+    rf->second_row = ROW_HEADER_SIZE + (size_t)original_n * 4;
+    rf->end = rf->second_row + (size_t)sorted_bytes;
+    return 0;
+}
+
+/* декодирование строки двоичного файла пачками в получателя */
+static int row_file_decode(RowFile *rf, int row, IntSink sink, void *ctx,
+                           NumberParseStats *stats)
+{
+    int batch[PARSE_BATCH];
+    size_t used = 0;
+    RowChecksum sum;
+    checksum_init(&sum);
+    memset(stats, 0, sizeof(*stats));
+
+    if (row == 0) {
+        const unsigned char *p = (const unsigned char *)rf->data + ROW_HEADER_SIZE;
+        for (size_t done = 0; done < rf->count[0]; done += used) {
+            used = rf->count[0] - done < PARSE_BATCH ? rf->count[0] - done : PARSE_BATCH;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            memcpy(batch, p + done * 4, used * sizeof(int));
+#else
+            for (size_t i = 0; i < used; i++)
+                batch[i] = (int)get_u32(p + (done + i) * 4);
+#endif
+            checksum_add(&sum, batch, used);
+            if (sink(ctx, batch, used) != 0)
+                return -1;
+        }
+    } else {
+        const unsigned char *p = (const unsigned char *)rf->data + rf->second_row;
+        const unsigned char *end = (const unsigned char *)rf->data + rf->end;
+        int prev = 0;
+        for (size_t i = 0; i < rf->count[1]; i++) {
+            uint64_t v = 0;
+            int shift = 0;
+            for (;;) {
+                if (p == end || shift > 63) {
+                    rf->corrupt = 1;
+                    return -1;
+                }
+                unsigned char byte = *p++;
+                v |= (uint64_t)(byte & 0x7F) << shift;
+                shift += 7;
+                if (!(byte & 0x80))
+                    break;
+            }
+            /* сложение по модулю 2^32: испорченные данные не дают UB */
+            uint64_t d = (v >> 1) ^ (0 - (v & 1));
+            prev = (int)(uint32_t)((uint32_t)prev + (uint32_t)d);
+            batch[used++] = prev;
+            if (used == PARSE_BATCH) {
+                checksum_add(&sum, batch, used);
+                if (sink(ctx, batch, used) != 0)
+                    return -1;
+                used = 0;
+            }
+        }
+        checksum_add(&sum, batch, used);
+        if (used > 0 && sink(ctx, batch, used) != 0)
+            return -1;
     }
-    printf("\n");
+
+    if (checksum_value(&sum) != rf->checksum[row]) {
+        rf->corrupt = 1;
+        return -1;
+    }
+    stats->parsed = rf->count[row];
+    return 0;
+}
+
+RowFormat row_format_for_filename(const char *filename)
+{
+    size_t len = strlen(filename);
+    if (len >= 4 && strcmp(filename + len - 4, ".bin") == 0)
+        return ROW_FORMAT_BINARY;
+    return ROW_FORMAT_TEXT;
+}
+
+/* ==================== ФАЙЛ ИЗ ДВУХ СТРОК (mmap) ==================== */
+
+#define ROW_UNKNOWN ((size_t)-1)
+
+int row_file_open(RowFile *rf, const char *filename)
+{
+    memset(rf, 0, sizeof(*rf));
+    rf->data = "";
+    rf->second_row = ROW_UNKNOWN;
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    /* пустой файл не отображается: обе строки просто пусты */
+    if (st.st_size > 0) {
+        void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            close(fd);
+            return -1;
+        }
+        /* файл читается один раз от начала к концу */
+        madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+        rf->data = (const char *)map;
+        rf->size = (size_t)st.st_size;
+    }
+
+    close(fd);  /* отображение остается действительным */
+
+    /* формат определяется по сигнатуре, а не по имени файла */
+    if (rf->size >= 4 && memcmp(rf->data, ROW_BINARY_MAGIC, 4) == 0) {
+        rf->format = ROW_FORMAT_BINARY;
+        if (row_file_parse_header(rf) != 0) {
+            row_file_close(rf);
+            return -2;
+        }
+    }
+    return 0;
+}
+
+void row_file_close(RowFile *rf)
+{
+    if (rf->size > 0)
+        munmap((void *)rf->data, rf->size);
+    rf->data = "";
+    rf->size = 0;
+}
+
+/* границы строки row; конец первой строки ищется только при первом запросе */
+static void row_file_bounds(RowFile *rf, int row, size_t *begin, size_t *end)
+{
+    if (rf->second_row == ROW_UNKNOWN) {
+        const char *nl = (const char *)memchr(rf->data, '\n', rf->size);
+        rf->second_row = nl ? (size_t)(nl - rf->data) + 1 : rf->size;
+    }
+
+    if (row == 0) {
+        *begin = 0;
+        *end = rf->second_row;
+        return;
+    }
+
+    *begin = rf->second_row;
+    const char *nl = *begin < rf->size
+                   ? (const char *)memchr(rf->data + *begin, '\n', rf->size - *begin)
+                   : NULL;
+    *end = nl ? (size_t)(nl - rf->data) : rf->size;
+}
+
+size_t row_file_read(RowFile *rf, int row, int **out_data, NumberParseStats *stats)
+{
+    NumberParseStats local_stats;
+    IntArray arr = { NULL, 0, 0 };
+    int result;
+
+    if (!stats)
+        stats = &local_stats;
+    if (rf->format == ROW_FORMAT_BINARY) {
+        /* длина известна заранее: один буфер без перевыделений */
+        if (rf->count[row] > 0) {
+            arr.data = (int *)malloc(rf->count[row] * sizeof(int));
+            arr.capacity = arr.data ? rf->count[row] : 0;
+        }
+        result = row_file_decode(rf, row, array_sink, &arr, stats);
+    } else {
+        size_t begin, end;
+        row_file_bounds(rf, row, &begin, &end);
+        result = parse_memory(rf->data + begin, end - begin, array_sink, &arr, stats);
+    }
+
+    if (result != 0) {
+        free(arr.data);
+        *out_data = NULL;
+        return 0;
+    }
+
+    *out_data = arr.data;
+    return arr.size;
+}
+
+int row_file_read_to_queue(RowFile *rf, int row, Queue *q, NumberParseStats *stats)
+{
+    if (rf->format == ROW_FORMAT_BINARY) {
+        NumberParseStats local_stats;
+        return row_file_decode(rf, row, queue_sink, q, stats ? stats : &local_stats);
+    }
+
+    size_t begin, end;
+    row_file_bounds(rf, row, &begin, &end);
+    return parse_memory(rf->data + begin, end - begin, queue_sink, q, stats);
 }
 
 int load_previous_rows(const char *filename,
                        int **prev_original, size_t *prev_original_n,
                        int **prev_sorted,   size_t *prev_sorted_n)
 {
-    FILE *f = fopen(filename, "r");
-    if (!f)
-        return -1;  /* файла нет – это не ошибка программы */
-
-    int   *orig   = NULL;
-    int   *sorted = NULL;
-    size_t orig_n   = read_ints_from_stream(f, &orig);
-    size_t sorted_n = read_ints_from_stream(f, &sorted);
-
-    fclose(f);
+    RowFile rf;
+    int status = row_file_open(&rf, filename);
+    if (status != 0)
+        return status;  /* файла нет – это не ошибка программы */
 
+    /* ненужные строки не разбираются вовсе */
     if (prev_original) {
-        *prev_original = orig;
+        size_t n = row_file_read(&rf, 0, prev_original, NULL);
         if (prev_original_n)
-            *prev_original_n = orig_n;
-    } else {
-        free(orig);
+            *prev_original_n = n;
     }
 
     if (prev_sorted) {
-        *prev_sorted = sorted;
+        size_t n = row_file_read(&rf, 1, prev_sorted, NULL);
         if (prev_sorted_n)
-            *prev_sorted_n = sorted_n;
-    } else {
-        free(sorted);
+            *prev_sorted_n = n;
     }
 
-    return 0;
+    status = rf.corrupt ? -2 : 0;
+    row_file_close(&rf);
+    return status;
 }
 
-int save_rows(const char *filename,
-              const int *original, size_t original_n,
-              const int *sorted,   size_t sorted_n)
+int save_rows_format(const char *filename, RowFormat format,
+                     const int *original, size_t original_n,
+                     const int *sorted,   size_t sorted_n)
 {
-    FILE *f = fopen(filename, "w");
+    FILE *f = fopen(filename, format == ROW_FORMAT_BINARY ? "wb" : "w");
     if (!f)
         return -1;
 
-    for (size_t i = 0; i < original_n; ++i) {
-        fprintf(f, "%d", original[i]);
-        if (i + 1 < original_n)
-            fprintf(f, " ");
+    if (format == ROW_FORMAT_BINARY) {
+        int status = save_rows_binary(f, original, original_n, sorted, sorted_n);
+        if (fclose(f) != 0)
+            status = -1;
+        return status;
     }
-    fprintf(f, "\n");
 
-    for (size_t i = 0; i < sorted_n; ++i) {
-        fprintf(f, "%d", sorted[i]);
-        if (i + 1 < sorted_n)
-            fprintf(f, " ");
-    }
-    fprintf(f, "\n");
+    IntWriter w;
+    int_writer_init(&w, f);
+    int_writer_ints(&w, original, original_n);
+    int_writer_newline(&w);
+    int_writer_ints(&w, sorted, sorted_n);
+    int_writer_newline(&w);
 
-    fclose(f);
-    return 0;
+    int status = int_writer_flush(&w);
+    if (fclose(f) != 0)
+        status = -1;
+    return status;
+}
+
+int save_rows(const char *filename,
+              const int *original, size_t original_n,
+              const int *sorted,   size_t sorted_n)
+{
+    return save_rows_format(filename, row_format_for_filename(filename),
+                            original, original_n, sorted, sorted_n);
 }
@@ -2,14 +2,84 @@
 #define NUMBER_IO_H
 
 #include <stddef.h>
+#include <stdio.h>
+#include "queue.h"
+
+/* итоги разбора строки; неверные лексемы пропускаются */
+typedef struct NumberParseStats {
+    size_t parsed;     /* прочитано чисел */
+    size_t overflow;   /* числа вне диапазона int */
+    size_t invalid;    /* лексемы, не являющиеся числами */
+} NumberParseStats;
+
+/* получатель разобранных чисел (пачками); 0 - продолжать, иначе ошибка */
+typedef int (*IntSink)(void *ctx, const int *values, size_t n);
+
+/* все числа потока до конца файла, в любом числе строк, пачками в sink;
+   память не зависит от длины входа. 0 - успех, -1 - ошибка */
+int read_ints_stream(FILE *stream, IntSink sink, void *ctx, NumberParseStats *stats);
+
+/* все числа потока до конца файла в конец очереди;
+   0 - успех, -1 - ошибка чтения или нехватка памяти */
+int read_ints_stream_to_queue(FILE *stream, Queue *q, NumberParseStats *stats);
+
+/* одна строка чисел любой длины из потока; stats может быть NULL */
+size_t read_ints_line(FILE *stream, int **out_data, NumberParseStats *stats);
+
+/* то же, но числа сразу добавляются в конец очереди, без массива;
+   1 - строка прочитана, 0 - конец файла, -1 - не хватило памяти */
+int read_ints_line_to_queue(FILE *stream, Queue *q, NumberParseStats *stats);
 
 size_t read_ints_from_stdin(int **out_data);
+
+/* строка чисел с клавиатуры прямо в очередь (без приглашения);
+   возвращает число добавленных значений */
+size_t read_queue_from_stdin(Queue *q);
 void   print_int_array(const int *data, size_t n);
 
+/* формат файла с рядами: текст (по умолчанию) или двоичный (.bin):
+   исходный ряд как int32, отсортированный - разности varint */
+typedef enum RowFormat {
+    ROW_FORMAT_TEXT = 0,
+    ROW_FORMAT_BINARY
+} RowFormat;
+
+/* файл из двух строк (исходный и отсортированный ряд), отображенный
+   в память через mmap; строки разбираются только по запросу */
+typedef struct RowFile {
+    const char *data;    /* отображение файла ("" для пустого) */
+    size_t size;
+    size_t second_row;   /* начало второй строки, находится лениво */
+    RowFormat format;    /* определяется по сигнатуре при открытии */
+    size_t end;          /* конец данных двоичного файла */
+    size_t count[2];     /* длины рядов двоичного файла */
+    unsigned checksum[2];
+    int corrupt;         /* не сошлась контрольная сумма */
+} RowFile;
+
+/* 0 - успех, -1 - файла нет или его не удалось отобразить,
+   -2 - двоичный файл поврежден */
+int  row_file_open(RowFile *rf, const char *filename);
+void row_file_close(RowFile *rf);
+
+/* разбор строки row (0 - исходный ряд, 1 - отсортированный) */
+size_t row_file_read(RowFile *rf, int row, int **out_data, NumberParseStats *stats);
+int    row_file_read_to_queue(RowFile *rf, int row, Queue *q, NumberParseStats *stats);
+
+/* формат по расширению имени: ".bin" - двоичный, иначе текст */
+RowFormat row_format_for_filename(const char *filename);
+
+/* 0 - успех, -1 - файла нет, -2 - файл поврежден */
 int load_previous_rows(const char *filename,
                        int **prev_original, size_t *prev_original_n,
                        int **prev_sorted,   size_t *prev_sorted_n);
 
+/* запись в явно заданном формате */
+int save_rows_format(const char *filename, RowFormat format,
+                     const int *original, size_t original_n,
+                     const int *sorted,   size_t sorted_n);
+
+/* формат выбирается по расширению имени файла */
 int save_rows(const char *filename,
               const int *original, size_t original_n,
               const int *sorted,   size_t sorted_n);
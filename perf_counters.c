@@ -0,0 +1,156 @@
+#include "perf_counters.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+static const char *counter_names[PERF_COUNTER_COUNT] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "dtlb_misses"
+};
+
+static char last_error[128];
+
+const char* perf_counter_name(PerfCounterId id)
+{
+    if (id < 0 || id >= PERF_COUNTER_COUNT)
+        return "unknown";
+    return counter_names[id];
+}
+
+const char* perf_counters_error(void)
+{
+    return last_error;
+}
+
+#ifdef __linux__
+
+// Промах кэша данных: тип PERF_TYPE_HW_CACHE, код кэш | операция | итог
+#define CACHE_READ_MISS(cache) \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+static int open_counter(uint32_t type, uint64_t config)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;           // Потоки параллельной сортировки тоже учитываются
+    attr.exclude_kernel = 1;    // Доступно при perf_event_paranoid <= 2
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+int perf_counters_open(PerfCounters *pc)
+{
+    static const struct { uint32_t type; uint64_t config; } events[PERF_COUNTER_COUNT] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D)},
+        {PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_LL)},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        {PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_DTLB)},
+    };
+
+    pc->opened = 0;
+    last_error[0] = 0;
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        pc->fds[i] = open_counter(events[i].type, events[i].config);
+        if (pc->fds[i] >= 0)
+            pc->opened++;
+        else if (!last_error[0])
+            snprintf(last_error, sizeof(last_error), "%s: %s",
+                     counter_names[i], strerror(errno));
+    }
+    return pc->opened;
+}
+
+void perf_counters_close(PerfCounters *pc)
+{
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if (pc->fds[i] >= 0)
+            close(pc->fds[i]);
+        pc->fds[i] = -1;
+    }
+    pc->opened = 0;
+}
+
+static int read_counter(int fd, PerfReading *r)
+{
+    return read(fd, r, sizeof(*r)) == (ssize_t)sizeof(*r) ? 0 : -1;
+}
+
+// RESET не обнуляет то, что досчитали уже завершившиеся унаследованные
+// потоки, поэтому запоминаются показания на старте и считается разность
+void perf_counters_start(PerfCounters *pc)
+{
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if (pc->fds[i] < 0)
+            continue;
+        if (read_counter(pc->fds[i], &pc->start[i]) != 0)
+            memset(&pc->start[i], 0, sizeof(pc->start[i]));
+        ioctl(pc->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void perf_counters_stop(PerfCounters *pc, double values[PERF_COUNTER_COUNT])
+{
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if (pc->fds[i] >= 0)
+            ioctl(pc->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        PerfReading r;
+        values[i] = -1;
+        if (pc->fds[i] < 0 || read_counter(pc->fds[i], &r) != 0)
+            continue;
+        r.value -= pc->start[i].value;
+        r.time_enabled -= pc->start[i].time_enabled;
+        r.time_running -= pc->start[i].time_running;
+        // Счетчик, ни разу не получивший регистр, ничего не знает
+        if (r.time_running == 0)
+            continue;
+        values[i] = (double)r.value;
+        if (r.time_running < r.time_enabled)
+            values[i] *= (double)r.time_enabled / (double)r.time_running;
+    }
+}
+
+#else
+
+int perf_counters_open(PerfCounters *pc)
+{
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+        pc->fds[i] = -1;
+    pc->opened = 0;
+    snprintf(last_error, sizeof(last_error), "perf_event_open есть только в Linux");
+    return 0;
+}
+
+void perf_counters_close(PerfCounters *pc)
+{
+    pc->opened = 0;
+}
+
+void perf_counters_start(PerfCounters *pc)
+{
+    (void)pc;
+}
+
+void perf_counters_stop(PerfCounters *pc, double values[PERF_COUNTER_COUNT])
+{
+    (void)pc;
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+        values[i] = -1;
+}
+
+#endif /* __linux__ */
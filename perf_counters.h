@@ -0,0 +1,54 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdint.h>
+
+//АППАРАТНЫЕ СЧЕТЧИКИ ПРОЦЕССОРА (Linux perf_event_open)
+//Каждый счетчик открывается отдельно, поэтому недоступный (нет поддержки
+//в процессоре, виртуальная машина, запрет perf_event_paranoid) просто
+//пропускается. Считается только пользовательский код вызывающего потока
+//и созданных после открытия потоков. При нехватке аппаратных регистров
+//ядро чередует счетчики; значения масштабируются на долю времени работы.
+//На других системах ни один счетчик не открывается.
+
+typedef enum PerfCounterId {
+    PERF_CYCLES = 0,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_DTLB_MISSES,
+    PERF_COUNTER_COUNT
+} PerfCounterId;
+
+//Значение счетчика и время, пока он был включен и реально считал
+typedef struct PerfReading {
+    uint64_t value;
+    uint64_t time_enabled;
+    uint64_t time_running;
+} PerfReading;
+
+typedef struct PerfCounters {
+    int fds[PERF_COUNTER_COUNT];        // -1 - счетчик недоступен
+    int opened;                         // Сколько счетчиков открыто
+    PerfReading start[PERF_COUNTER_COUNT];  // Показания в момент запуска
+} PerfCounters;
+
+//Открытие всех счетчиков; возвращает число открытых (0 - недоступны)
+int perf_counters_open(PerfCounters *pc);
+void perf_counters_close(PerfCounters *pc);
+
+//Запуск счетчиков с запоминанием текущих показаний
+void perf_counters_start(PerfCounters *pc);
+
+//Остановка и чтение прироста с момента запуска; для недоступного
+//счетчика в values пишется -1
+void perf_counters_stop(PerfCounters *pc, double values[PERF_COUNTER_COUNT]);
+
+//Название счетчика ("cycles", "instructions", ...)
+const char* perf_counter_name(PerfCounterId id);
+
+//Текст последней ошибки открытия (пустая строка, если ее не было)
+const char* perf_counters_error(void);
+
+#endif /* PERF_COUNTERS_H */
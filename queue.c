@@ -1,20 +1,599 @@
 #include "queue.h"
+#include "simd_sort.h"
+#include "fast_io.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+#define POOL_FIRST_SLAB 64        // Размер первого блока пула (в узлах)
+#define POOL_MAX_SLAB   65536     // Дальше блоки перестают расти
+#define RING_FIRST_CAPACITY 16    // Начальный размер кольцевого буфера
+#define INDEX_DEFAULT_STRIDE 64   // Шаг позиционного индекса по умолчанию
+#define INDEX_COMPACT_MIN 64      // Сдвигать индекс, когда спереди столько устаревших записей
+#define AUTO_SMALL_SIZE 64        // Автовыбор: до этого размера - адаптивная сортировка
+#define AUTO_RUN_RATIO  16        // Автовыбор: средняя серия длиннее - данные почти упорядочены
+#define AUTO_COUNTING_LIST_RATIO  1.0   // Автовыбор: подсчет для списка при диапазоне до size
+#define AUTO_COUNTING_ARRAY_RATIO 0.25  // и для массивов до size / 4 (--benchmark-counting)
+#define SELECT_DEPTH_FACTOR 2     // Быстрый выбор: до 2 * log2(n) разбиений, дальше - куча
+#define RADIX_BITS    8           // Поразрядная сортировка: байт за проход
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_PASSES  (int)(sizeof(int) * 8 / RADIX_BITS)
+
+// Ключ поразрядной сортировки: инверсия знакового бита переводит
+// порядок int в порядок unsigned (отрицательные числа идут первыми)
+#define RADIX_KEY(v) ((unsigned int)(v) ^ 0x80000000u)
+
+/* ==================== УЧЕТ ПАМЯТИ ==================== */
+// Все выделения хранилища очереди идут через эти функции,
+// чтобы в q->mem были видны число вызовов и занятые байты
+
+static void mem_note_alloc(QueueMemStats *mem, size_t bytes)
+{
+    mem->allocs++;
+    mem->bytes_live += bytes;
+    if (mem->bytes_live > mem->bytes_peak)
+        mem->bytes_peak = mem->bytes_live;
+}
+
+static void* mem_alloc(QueueMemStats *mem, size_t bytes)
+{
+    void *ptr = malloc(bytes);
+    if (ptr)
+        mem_note_alloc(mem, bytes);
+    return ptr;
+}
+
+static void* mem_realloc(QueueMemStats *mem, void *ptr, size_t old_bytes, size_t new_bytes)
+{
+    void *grown = realloc(ptr, new_bytes);
+    if (grown) {
+        mem->bytes_live -= old_bytes;
+        mem_note_alloc(mem, new_bytes);
+    }
+    return grown;
+}
+
+static void mem_free(QueueMemStats *mem, void *ptr, size_t bytes)
+{
+    if (!ptr)
+        return;
+    free(ptr);
+    mem->frees++;
+    mem->bytes_live -= bytes;
+}
+
+/* ==================== ПУЛ УЗЛОВ ==================== */
+
+static void pool_init(QueueNodePool *pool)
+{
+    pool->slabs = NULL;
+    pool->free_list = NULL;
+    pool->next_capacity = POOL_FIRST_SLAB;
+}
+
+// Выделение нового блока минимум на min_nodes узлов
+static QueueSlab* pool_add_slab(QueueNodePool *pool, QueueMemStats *mem, size_t min_nodes)
+{
+    size_t capacity = pool->next_capacity;
+    if (capacity < min_nodes)
+        capacity = min_nodes;
+
+    QueueSlab *slab = (QueueSlab *)mem_alloc(mem, sizeof(QueueSlab) +
+                                             capacity * sizeof(QueueNode));
+    if (!slab)
+        return NULL;
+
+    slab->capacity = capacity;
+    slab->used = 0;
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+
+    if (pool->next_capacity < POOL_MAX_SLAB)
+        pool->next_capacity *= 2;
+    return slab;
+}
+
+// Взять узел из пула: сначала из списка свободных, потом из текущего блока
+static QueueNode* pool_alloc(QueueNodePool *pool, QueueMemStats *mem)
+{
+    QueueNode *node = pool->free_list;
+    if (node) {
+        pool->free_list = node->next;
+        return node;
+    }
+
+    QueueSlab *slab = pool->slabs;
+    if (!slab || slab->used == slab->capacity) {
+        slab = pool_add_slab(pool, mem, 1);
+        if (!slab)
+            return NULL;
+    }
+    return &slab->nodes[slab->used++];
+}
+
+// Вернуть узел в пул (память не освобождается)
+static void pool_release(QueueNodePool *pool, QueueNode *node)
+{
+    node->next = pool->free_list;
+    pool->free_list = node;
+}
+
+// Получить n подряд идущих свободных узлов одним выделением
+static QueueNode* pool_alloc_run(QueueNodePool *pool, QueueMemStats *mem, size_t n)
+{
+    QueueSlab *slab = pool->slabs;
+    if (!slab || slab->capacity - slab->used < n) {
+        slab = pool_add_slab(pool, mem, n);
+        if (!slab)
+            return NULL;
+    }
+    QueueNode *run = &slab->nodes[slab->used];
+    slab->used += n;
+    return run;
+}
+
+// Освобождение всех блоков: O(число блоков), а не O(число элементов)
+static void pool_destroy(QueueNodePool *pool, QueueMemStats *mem)
+{
+    QueueSlab *slab = pool->slabs;
+    while (slab) {
+        QueueSlab *next = slab->next;
+        mem_free(mem, slab, sizeof(QueueSlab) + slab->capacity * sizeof(QueueNode));
+        slab = next;
+    }
+    pool_init(pool);
+}
+
+/* ==================== КОЛЬЦЕВОЙ БУФЕР ==================== */
+
+// Перенос элементов в новый массив нужного размера, первый элемент - в data[0]
+static int ring_realloc(Queue *q, size_t new_capacity)
+{
+    QueueRing *r = &q->ring;
+    int *data = (int *)mem_alloc(&q->mem, new_capacity * sizeof(int));
+    if (!data)
+        return -1;
+
+    size_t first = r->capacity - r->head;
+    if (first > q->size)
+        first = q->size;
+    if (q->size) {
+        memcpy(data, r->data + r->head, first * sizeof(int));
+        memcpy(data + first, r->data, (q->size - first) * sizeof(int));
+    }
+
+    mem_free(&q->mem, r->data, r->capacity * sizeof(int));
+    r->data = data;
+    r->capacity = new_capacity;
+    r->head = 0;
+    return 0;
+}
+
+static int ring_push(Queue *q, int value)
+{
+    QueueRing *r = &q->ring;
+    if (q->size == r->capacity &&
+        ring_realloc(q, r->capacity ? r->capacity * 2 : RING_FIRST_CAPACITY) != 0)
+        return -1;
+
+    size_t pos = r->head + q->size;
+    if (pos >= r->capacity)
+        pos -= r->capacity;
+    r->data[pos] = value;
+    q->size++;
+    return 0;
+}
+
+static int ring_pop(Queue *q, int *value)
+{
+    QueueRing *r = &q->ring;
+    if (q->size == 0)
+        return -1;
+
+    if (value)
+        *value = r->data[r->head];
+    if (++r->head == r->capacity)
+        r->head = 0;
+    q->size--;
+    return 0;
+}
+
+// Элемент с номером index (от начала очереди)
+static int* ring_at(const Queue *q, size_t index)
+{
+    size_t pos = q->ring.head + index;
+    if (pos >= q->ring.capacity)
+        pos -= q->ring.capacity;
+    return &q->ring.data[pos];
+}
+
+static void reverse_ints(int *a, size_t n)
+{
+    for (size_t i = 0, j = n; i + 1 < j; i++, j--) {
+        int t = a[i];
+        a[i] = a[j - 1];
+        a[j - 1] = t;
+    }
+}
+
+// Делает элементы непрерывными и возвращает указатель на первый.
+// Разорванный буфер поворачивается на месте тремя разворотами
+// (первый элемент встает в data[0]), поэтому память не нужна
+static int* ring_linearize(Queue *q)
+{
+    QueueRing *r = &q->ring;
+    if (r->head + q->size > r->capacity) {
+        reverse_ints(r->data, r->head);
+        reverse_ints(r->data + r->head, r->capacity - r->head);
+        reverse_ints(r->data, r->capacity);
+        r->head = 0;
+    }
+    return r->data + r->head;
+}
+
+/* ==================== СПИСОК БЛОКОВ ==================== */
+
+// Новый блок: освободившийся ранее или выделенный заново
+static QueueChunk* chunk_alloc(QueueChunks *c, QueueMemStats *mem)
+{
+    QueueChunk *chunk = c->spare;
+    if (chunk) {
+        c->spare = NULL;
+    } else {
+        chunk = (QueueChunk *)mem_alloc(mem, sizeof(QueueChunk));
+        if (!chunk)
+            return NULL;
+    }
+    chunk->next = NULL;
+    return chunk;
+}
+
+// Один пустой блок придерживаем, чтобы чередование push/pop
+// на границе блока не вызывало malloc/free
+static void chunk_release(QueueChunks *c, QueueMemStats *mem, QueueChunk *chunk)
+{
+    if (!c->spare)
+        c->spare = chunk;
+    else
+        mem_free(mem, chunk, sizeof(QueueChunk));
+}
+
+// Добавление n значений в конец, копирование целыми кусками блоков
+// Все недостающие блоки выделяются заранее: при нехватке памяти
+// очередь остается прежней
+static int chunks_push_array(Queue *q, const int *values, size_t n)
+{
+    QueueChunks *c = &q->chunks;
+    size_t room = c->tail ? QUEUE_CHUNK_CAPACITY - c->tail_off : 0;
+    size_t need = n > room ? (n - room + QUEUE_CHUNK_CAPACITY - 1) / QUEUE_CHUNK_CAPACITY : 0;
+
+    QueueChunk *fresh = NULL;
+    for (size_t i = 0; i < need; i++) {
+        QueueChunk *chunk = chunk_alloc(c, &q->mem);
+        if (!chunk) {
+            while (fresh) {
+                QueueChunk *next = fresh->next;
+                chunk_release(c, &q->mem, fresh);
+                fresh = next;
+            }
+            return -1;
+        }
+        chunk->next = fresh;
+        fresh = chunk;
+    }
+
+    while (n > 0) {
+        if (!c->tail || c->tail_off == QUEUE_CHUNK_CAPACITY) {
+            QueueChunk *chunk = fresh;
+            fresh = chunk->next;
+            chunk->next = NULL;
+            if (c->tail) {
+                c->tail->next = chunk;
+            } else {
+                c->head = chunk;
+                c->head_off = 0;
+            }
+            c->tail = chunk;
+            c->tail_off = 0;
+        }
+
+        size_t part = QUEUE_CHUNK_CAPACITY - c->tail_off;
+        if (part > n)
+            part = n;
+        memcpy(c->tail->values + c->tail_off, values, part * sizeof(int));
+        c->tail_off += part;
+        q->size += part;
+        values += part;
+        n -= part;
+    }
+    return 0;
+}
+
+static int chunks_pop(Queue *q, int *value)
+{
+    QueueChunks *c = &q->chunks;
+    if (q->size == 0)
+        return -1;
+
+    if (value)
+        *value = c->head->values[c->head_off];
+    c->head_off++;
+    q->size--;
+
+    if (q->size == 0) {
+        // Остался один пустой блок (head == tail) - начинаем его заново
+        c->head_off = c->tail_off = 0;
+    } else if (c->head_off == QUEUE_CHUNK_CAPACITY) {
+        QueueChunk *old = c->head;
+        c->head = old->next;
+        c->head_off = 0;
+        chunk_release(c, &q->mem, old);
+    }
+    return 0;
+}
+
+// Элемент с номером index: целые блоки пропускаются без просмотра
+static int* chunks_at(const Queue *q, size_t index)
+{
+    size_t pos = q->chunks.head_off + index;
+    QueueChunk *chunk = q->chunks.head;
+    while (pos >= QUEUE_CHUNK_CAPACITY) {
+        chunk = chunk->next;
+        pos -= QUEUE_CHUNK_CAPACITY;
+    }
+    return &chunk->values[pos];
+}
+
+// Запись значений из массива обратно в блоки (порядок элементов сохраняется)
+static void chunks_scatter(Queue *q, const int *values)
+{
+    size_t off = q->chunks.head_off, left = q->size;
+    for (QueueChunk *chunk = q->chunks.head; left > 0; chunk = chunk->next) {
+        size_t part = QUEUE_CHUNK_CAPACITY - off;
+        if (part > left)
+            part = left;
+        memcpy(chunk->values + off, values, part * sizeof(int));
+        values += part;
+        left -= part;
+        off = 0;
+    }
+}
+
+// Позиция в списке блоков для прохода вперед
+typedef struct ChunkCursor {
+    QueueChunk *chunk;
+    size_t off;
+} ChunkCursor;
+
+static void chunk_cursor_advance(ChunkCursor *cur, size_t steps)
+{
+    cur->off += steps;
+    while (cur->off >= QUEUE_CHUNK_CAPACITY) {
+        cur->chunk = cur->chunk->next;
+        cur->off -= QUEUE_CHUNK_CAPACITY;
+    }
+}
+
+// Сортировка расческой прямо в блоках - запасной вариант без выделения
+// памяти. Сравниваются элементы на расстоянии gap, оба курсора идут
+// только вперед, поэтому проход занимает O(n)
+static void chunks_comb_sort(Queue *q)
+{
+    size_t gap = q->size;
+    int swapped = 1;
+    while (gap > 1 || swapped) {
+        gap = gap * 10 / 13;
+        if (gap == 9 || gap == 10)
+            gap = 11;
+        if (gap < 1)
+            gap = 1;
+
+        ChunkCursor lo = {q->chunks.head, q->chunks.head_off};
+        ChunkCursor hi = lo;
+        chunk_cursor_advance(&hi, gap);
+        swapped = 0;
+        for (size_t i = gap; i < q->size; i++) {
+            int *a = &lo.chunk->values[lo.off], *b = &hi.chunk->values[hi.off];
+            if (*b < *a) {
+                int t = *a;
+                *a = *b;
+                *b = t;
+                swapped = 1;
+            }
+            chunk_cursor_advance(&lo, 1);
+            if (i + 1 < q->size)
+                chunk_cursor_advance(&hi, 1);
+        }
+    }
+}
+
+static void chunks_destroy(QueueChunks *c, QueueMemStats *mem)
+{
+    QueueChunk *chunk = c->head;
+    while (chunk) {
+        QueueChunk *next = chunk->next;
+        mem_free(mem, chunk, sizeof(QueueChunk));
+        chunk = next;
+    }
+    mem_free(mem, c->spare, sizeof(QueueChunk));
+    c->head = c->tail = c->spare = NULL;
+    c->head_off = c->tail_off = 0;
+}
+
+/* ==================== ПОЗИЦИОННЫЙ ИНДЕКС ==================== */
+// Каждый узел списка получает абсолютную позицию: номер среди всех когда-либо
+// добавленных с момента построения индекса. nodes[e] - узел с позицией
+// e * stride; base - абсолютная позиция текущей головы. Записи с номером
+// меньше first уже извлечены из очереди.
+
+static void index_reset(QueueIndex *ix, QueueMemStats *mem)
+{
+    mem_free(mem, ix->nodes, ix->capacity * sizeof(QueueNode *));
+    ix->nodes = NULL;
+    ix->first = ix->count = ix->capacity = 0;
+    ix->base = 0;
+    ix->valid = 0;
+}
+
+static int index_reserve(QueueIndex *ix, QueueMemStats *mem, size_t count)
+{
+    if (count <= ix->capacity)
+        return 0;
+
+    size_t capacity = ix->capacity ? ix->capacity * 2 : 16;
+    while (capacity < count)
+        capacity *= 2;
+    QueueNode **nodes = (QueueNode **)mem_realloc(mem, ix->nodes,
+                                                  ix->capacity * sizeof(QueueNode *),
+                                                  capacity * sizeof(QueueNode *));
+    if (!nodes)
+        return -1;
+    ix->nodes = nodes;
+    ix->capacity = capacity;
+    return 0;
+}
+
+// Полное построение индекса проходом по списку
+static void index_rebuild(Queue *q)
+{
+    QueueIndex *ix = &q->index;
+    size_t count = (q->size + ix->stride - 1) / ix->stride;
+    if (index_reserve(ix, &q->mem, count) != 0)
+        return;
+
+    size_t pos = 0, e = 0;
+    for (QueueNode *node = q->head; node; node = node->next, pos++) {
+        if (pos % ix->stride == 0)
+            ix->nodes[e++] = node;
+    }
+    ix->first = 0;
+    ix->count = count;
+    ix->base = 0;
+    ix->valid = 1;
+}
+
+// Учет добавленных узлов: chain - первый из n новых узлов в конце списка
+static void index_note_push(Queue *q, QueueNode *chain, size_t n)
+{
+    QueueIndex *ix = &q->index;
+    if (!ix->valid)
+        return;
+
+    size_t pos = ix->base + q->size - n;
+    for (QueueNode *node = chain; n > 0; node = node->next, pos++, n--) {
+        if (pos % ix->stride != 0)
+            continue;
+        if (index_reserve(ix, &q->mem, ix->count + 1) != 0) {
+            ix->valid = 0;      // Построим заново при следующем обращении
+            return;
+        }
+        ix->nodes[ix->count++] = node;
+    }
+}
+
+// Учет n извлеченных из начала узлов
+static void index_note_pop(Queue *q, size_t n)
+{
+    QueueIndex *ix = &q->index;
+    if (!ix->valid)
+        return;
+
+    if (q->size == 0) {
+        ix->base = ix->first = ix->count = 0;
+        return;
+    }
+
+    ix->base += n;
+    ix->first = (ix->base + ix->stride - 1) / ix->stride;
+
+    // Устаревшие записи спереди вытесняются, когда их становится много.
+    // Сдвиг только на целое число шагов (base / stride), иначе при base,
+    // не кратном stride, base ушел бы в минус
+    if (ix->first >= INDEX_COMPACT_MIN && ix->first * 2 >= ix->count) {
+        size_t drop = ix->base / ix->stride;
+        memmove(ix->nodes, ix->nodes + drop,
+                (ix->count - drop) * sizeof(QueueNode *));
+        ix->count -= drop;
+        ix->base -= drop * ix->stride;
+        ix->first -= drop;
+    }
+}
+
+// Узел списка с номером index: от ближайшей записи индекса не больше stride шагов
+static QueueNode* list_node_at(Queue *q, size_t index)
+{
+    QueueIndex *ix = &q->index;
+    QueueNode *node = q->head;
+    size_t steps = index;
+
+    if (ix->stride) {
+        if (!ix->valid)
+            index_rebuild(q);
+        size_t pos = ix->base + index;
+        size_t e = pos / ix->stride;
+        if (ix->valid && e >= ix->first && e < ix->count) {
+            node = ix->nodes[e];
+            steps = pos - e * ix->stride;
+        }
+    }
+
+    for (size_t i = 0; i < steps; i++) {
+        node = node->next;
+    }
+    return node;
+}
+
+/* ==================== БАЗОВЫЕ ОПЕРАЦИИ ==================== */
+
+// Ячейка элемента с номером index (index < q->size)
+static int* slot_at(Queue *q, size_t index)
+{
+    switch (q->backend) {
+    case QUEUE_BACKEND_RING:
+        return ring_at(q, index);
+    case QUEUE_BACKEND_CHUNKED:
+        return chunks_at(q, index);
+    case QUEUE_BACKEND_LIST:
+    default:
+        return &list_node_at(q, index)->value;
+    }
+}
+
 // Инициализация пустой очереди
 void queue_init(Queue *q)
+{
+    queue_init_backend(q, QUEUE_BACKEND_LIST);
+}
+
+// Инициализация пустой очереди с заданным способом хранения
+void queue_init_backend(Queue *q, QueueBackend backend)
 {
     q->head = q->tail = NULL;
     q->size = 0;
+    q->backend = backend;
+    pool_init(&q->pool);
+    q->ring.data = NULL;
+    q->ring.capacity = 0;
+    q->ring.head = 0;
+    q->chunks.head = q->chunks.tail = q->chunks.spare = NULL;
+    q->chunks.head_off = q->chunks.tail_off = 0;
+    q->index.nodes = NULL;
+    q->index.stride = 0;
+    memset(&q->mem, 0, sizeof(q->mem));
+    index_reset(&q->index, &q->mem);
 }
 
 // Добавление элемента в конец очереди
 // Возвращает 0 при успехе, -1 при ошибке
 int queue_push(Queue *q, int value)
 {
-    QueueNode *node = (QueueNode *)malloc(sizeof(QueueNode));
+    if (q->backend == QUEUE_BACKEND_RING)
+        return ring_push(q, value);
+    if (q->backend == QUEUE_BACKEND_CHUNKED)
+        return chunks_push_array(q, &value, 1);
+
+    QueueNode *node = pool_alloc(&q->pool, &q->mem);
     if (!node)
         return -1;
 
@@ -29,6 +608,7 @@ int queue_push(Queue *q, int value)
     
     q->tail = node;
     q->size++;
+    index_note_push(q, node, 1);
     return 0;
 }
 
@@ -36,6 +616,11 @@ int queue_push(Queue *q, int value)
 // Если value не NULL, сохраняет извлеченное значение
 int queue_pop(Queue *q, int *value)
 {
+    if (q->backend == QUEUE_BACKEND_RING)
+        return ring_pop(q, value);
+    if (q->backend == QUEUE_BACKEND_CHUNKED)
+        return chunks_pop(q, value);
+
     if (!q->head)
         return -1;
 
@@ -49,69 +634,851 @@ int queue_pop(Queue *q, int *value)
     if (!q->head)
         q->tail = NULL;
 
-    free(node);
-    q->size--;
-    return 0;
+    pool_release(&q->pool, node);
+    q->size--;
+    index_note_pop(q, 1);
+    return 0;
+}
+
+// Добавление n значений в конец очереди за один проход
+// Список берет узлы из списка свободных, а недостающие - одним куском пула;
+// кольцевой буфер и блоки копируют значения через memcpy.
+// При нехватке памяти очередь не меняется и возвращается -1
+int queue_push_n(Queue *q, const int *values, size_t n)
+{
+    if (n == 0)
+        return 0;
+
+    if (q->backend == QUEUE_BACKEND_RING) {
+        QueueRing *r = &q->ring;
+        if (q->size + n > r->capacity) {
+            size_t capacity = r->capacity ? r->capacity : RING_FIRST_CAPACITY;
+            while (capacity < q->size + n)
+                capacity *= 2;
+            if (ring_realloc(q, capacity) != 0)
+                return -1;
+        }
+        size_t pos = r->head + q->size;
+        if (pos >= r->capacity)
+            pos -= r->capacity;
+        size_t first = r->capacity - pos < n ? r->capacity - pos : n;
+        memcpy(r->data + pos, values, first * sizeof(int));
+        memcpy(r->data, values + first, (n - first) * sizeof(int));
+        q->size += n;
+        return 0;
+    }
+
+    if (q->backend == QUEUE_BACKEND_CHUNKED)
+        return chunks_push_array(q, values, n);
+
+    // Сначала переиспользуем освобожденные узлы
+    QueueNode *chain = NULL, *chain_tail = NULL;
+    size_t i = 0;
+    while (i < n && q->pool.free_list) {
+        QueueNode *node = q->pool.free_list;
+        q->pool.free_list = node->next;
+        node->value = values[i++];
+        if (chain_tail)
+            chain_tail->next = node;
+        else
+            chain = node;
+        chain_tail = node;
+    }
+
+    // Остальные узлы - подряд из одного куска пула
+    size_t rest = n - i;
+    if (rest > 0) {
+        QueueNode *run = pool_alloc_run(&q->pool, &q->mem, rest);
+        if (!run) {
+            if (chain_tail) {
+                chain_tail->next = q->pool.free_list;
+                q->pool.free_list = chain;
+            }
+            return -1;
+        }
+        for (size_t k = 0; k < rest; k++) {
+            run[k].value = values[i + k];
+            run[k].next = &run[k + 1];
+        }
+        if (chain_tail)
+            chain_tail->next = run;
+        else
+            chain = run;
+        chain_tail = &run[rest - 1];
+    }
+    chain_tail->next = NULL;
+
+    if (q->tail)
+        q->tail->next = chain;
+    else
+        q->head = chain;
+    q->tail = chain_tail;
+    q->size += n;
+    index_note_push(q, chain, n);
+    return 0;
+}
+
+// Извлечение до n значений из начала очереди в out
+// Возвращает число извлеченных значений
+size_t queue_pop_n(Queue *q, int *out, size_t n)
+{
+    if (n > q->size)
+        n = q->size;
+    if (n == 0)
+        return 0;
+
+    if (q->backend == QUEUE_BACKEND_RING) {
+        QueueRing *r = &q->ring;
+        size_t first = r->capacity - r->head < n ? r->capacity - r->head : n;
+        memcpy(out, r->data + r->head, first * sizeof(int));
+        memcpy(out + first, r->data, (n - first) * sizeof(int));
+        r->head += n;
+        if (r->head >= r->capacity)
+            r->head -= r->capacity;
+        q->size -= n;
+        return n;
+    }
+
+    if (q->backend == QUEUE_BACKEND_CHUNKED) {
+        QueueChunks *c = &q->chunks;
+        size_t left = n;
+        while (left > 0) {
+            size_t part = QUEUE_CHUNK_CAPACITY - c->head_off;
+            if (part > left)
+                part = left;
+            memcpy(out, c->head->values + c->head_off, part * sizeof(int));
+            out += part;
+            left -= part;
+            c->head_off += part;
+            q->size -= part;
+            if (q->size == 0) {
+                c->head_off = c->tail_off = 0;
+            } else if (c->head_off == QUEUE_CHUNK_CAPACITY) {
+                QueueChunk *old = c->head;
+                c->head = old->next;
+                c->head_off = 0;
+                chunk_release(c, &q->mem, old);
+            }
+        }
+        return n;
+    }
+
+    // Вся извлеченная цепочка узлов возвращается в пул одной операцией
+    QueueNode *first = q->head, *last = q->head;
+    out[0] = first->value;
+    for (size_t i = 1; i < n; i++) {
+        last = last->next;
+        out[i] = last->value;
+    }
+    q->head = last->next;
+    if (!q->head)
+        q->tail = NULL;
+    last->next = q->pool.free_list;
+    q->pool.free_list = first;
+    q->size -= n;
+    index_note_pop(q, n);
+    return n;
+}
+
+// Освобождение всей памяти, занятой очередью
+// Узлы не обходятся: пул отдает системе свои блоки целиком
+// Счетчики q->mem сохраняются (bytes_live становится 0)
+void queue_free(Queue *q)
+{
+    pool_destroy(&q->pool, &q->mem);
+    mem_free(&q->mem, q->ring.data, q->ring.capacity * sizeof(int));
+    q->ring.data = NULL;
+    q->ring.capacity = 0;
+    q->ring.head = 0;
+    chunks_destroy(&q->chunks, &q->mem);
+    index_reset(&q->index, &q->mem);
+    
+    q->head = q->tail = NULL;
+    q->size = 0;
+}
+
+// Запись значений очереди в поток одной строкой через пробел
+// Числа форматируются в общий буфер и выводятся крупными порциями
+int queue_write(const Queue *q, FILE *stream)
+{
+    if (q->size == 0)
+        return 0;
+
+    IntWriter w;
+    int_writer_init(&w, stream);
+
+    if (q->backend == QUEUE_BACKEND_RING) {
+        // Не более двух непрерывных отрезков буфера
+        size_t first = q->ring.capacity - q->ring.head;
+        if (first > q->size)
+            first = q->size;
+        int_writer_ints(&w, q->ring.data + q->ring.head, first);
+        int_writer_ints(&w, q->ring.data, q->size - first);
+    } else if (q->backend == QUEUE_BACKEND_CHUNKED) {
+        size_t off = q->chunks.head_off, left = q->size;
+        for (QueueChunk *chunk = q->chunks.head; left > 0; chunk = chunk->next) {
+            size_t n = QUEUE_CHUNK_CAPACITY - off;
+            if (n > left)
+                n = left;
+            int_writer_ints(&w, chunk->values + off, n);
+            left -= n;
+            off = 0;
+        }
+    } else {
+        for (QueueNode *node = q->head; node; node = node->next)
+            int_writer_int(&w, node->value);
+    }
+
+    int_writer_newline(&w);
+    return int_writer_flush(&w);
+}
+
+// Печать содержимого очереди
+void queue_print(const Queue *q)
+{
+    if (q->size == 0) {
+        printf("Очередь пуста\n");
+        return;
+    }
+    queue_write(q, stdout);
+}
+
+// Изменение значения элемента по индексу
+// Индексация с нуля
+int queue_edit_at(Queue *q, size_t index, int new_value)
+{
+    if (index >= q->size)
+        return -1;
+
+    *slot_at(q, index) = new_value;
+    return 0;
+}
+
+// Чтение значения элемента по индексу
+int queue_get_at(Queue *q, size_t index, int *value)
+{
+    if (index >= q->size)
+        return -1;
+
+    *value = *slot_at(q, index);
+    return 0;
+}
+
+// Включение позиционного индекса (только для связного списка)
+void queue_enable_index(Queue *q, size_t stride)
+{
+    if (q->backend != QUEUE_BACKEND_LIST)
+        return;
+    index_reset(&q->index, &q->mem);
+    q->index.stride = stride ? stride : INDEX_DEFAULT_STRIDE;
+}
+
+void queue_disable_index(Queue *q)
+{
+    index_reset(&q->index, &q->mem);
+    q->index.stride = 0;
+}
+
+// Индекс будет построен заново при следующем обращении по номеру
+void queue_invalidate_index(Queue *q)
+{
+    q->index.valid = 0;
+}
+
+// Проверка, пуста ли очередь
+int queue_is_empty(const Queue *q)
+{
+    return q->size == 0;
+}
+
+// Байт на элемент: пул держит и освобожденные узлы, поэтому после
+// извлечений значение растет, пока очередь не будет освобождена
+double queue_bytes_per_element(const Queue *q)
+{
+    if (q->size == 0)
+        return 0;
+    return (double)q->mem.bytes_live / (double)q->size;
+}
+
+// Неубывание a[0..n) с учетом предыдущего элемента prev (если есть)
+static int ints_sorted(const int *a, size_t n, const int *prev)
+{
+    if (n == 0)
+        return 1;
+    if (prev && a[0] < *prev)
+        return 0;
+    for (size_t i = 1; i < n; i++) {
+        if (a[i] < a[i - 1])
+            return 0;
+    }
+    return 1;
+}
+
+// Проверка упорядоченности по неубыванию за один проход
+int queue_is_sorted(const Queue *q)
+{
+    if (q->size < 2)
+        return 1;
+
+    switch (q->backend) {
+    case QUEUE_BACKEND_RING: {
+        size_t first = q->ring.capacity - q->ring.head;
+        if (first > q->size)
+            first = q->size;
+        const int *a = q->ring.data + q->ring.head;
+        return ints_sorted(a, first, NULL) &&
+               ints_sorted(q->ring.data, q->size - first, &a[first - 1]);
+    }
+    case QUEUE_BACKEND_CHUNKED: {
+        size_t off = q->chunks.head_off, left = q->size;
+        const int *prev = NULL;
+        for (QueueChunk *chunk = q->chunks.head; left > 0; chunk = chunk->next) {
+            size_t n = QUEUE_CHUNK_CAPACITY - off;
+            if (n > left)
+                n = left;
+            if (!ints_sorted(chunk->values + off, n, prev))
+                return 0;
+            prev = &chunk->values[off + n - 1];
+            left -= n;
+            off = 0;
+        }
+        return 1;
+    }
+    case QUEUE_BACKEND_LIST:
+    default:
+        for (const QueueNode *node = q->head; node->next; node = node->next) {
+            if (node->next->value < node->value)
+                return 0;
+        }
+        return 1;
+    }
+}
+
+// Сводка одного прохода по очереди для автовыбора сортировки
+typedef struct QueueOrder {
+    size_t ascents;     // Сколько раз соседние значения растут
+    size_t descents;    // и убывают
+    int min, max;       // Диапазон значений
+} QueueOrder;
+
+// Учет в сводке a[0..n) с учетом предыдущего элемента prev (если есть)
+static void ints_count_order(const int *a, size_t n, const int *prev, QueueOrder *order)
+{
+    if (n == 0)
+        return;
+    if (prev) {
+        order->ascents += a[0] > *prev;
+        order->descents += a[0] < *prev;
+    }
+    for (size_t i = 1; i < n; i++) {
+        order->ascents += a[i] > a[i - 1];
+        order->descents += a[i] < a[i - 1];
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (a[i] < order->min)
+            order->min = a[i];
+        if (a[i] > order->max)
+            order->max = a[i];
+    }
+}
+
+// Один проход по очереди: возрастания, убывания и диапазон значений
+static void queue_count_order(const Queue *q, QueueOrder *order)
+{
+    order->ascents = order->descents = 0;
+    order->min = order->max = 0;
+    if (q->size == 0)
+        return;
+    queue_front(q, &order->min);
+    order->max = order->min;
+
+    switch (q->backend) {
+    case QUEUE_BACKEND_RING: {
+        size_t first = q->ring.capacity - q->ring.head;
+        if (first > q->size)
+            first = q->size;
+        const int *a = q->ring.data + q->ring.head;
+        ints_count_order(a, first, NULL, order);
+        ints_count_order(q->ring.data, q->size - first, &a[first - 1], order);
+        break;
+    }
+    case QUEUE_BACKEND_CHUNKED: {
+        size_t off = q->chunks.head_off, left = q->size;
+        const int *prev = NULL;
+        for (QueueChunk *chunk = q->chunks.head; left > 0; chunk = chunk->next) {
+            size_t n = QUEUE_CHUNK_CAPACITY - off;
+            if (n > left)
+                n = left;
+            ints_count_order(chunk->values + off, n, prev, order);
+            prev = &chunk->values[off + n - 1];
+            left -= n;
+            off = 0;
+        }
+        break;
+    }
+    case QUEUE_BACKEND_LIST:
+    default:
+        for (const QueueNode *node = q->head; node; node = node->next) {
+            if (node->value < order->min)
+                order->min = node->value;
+            if (node->value > order->max)
+                order->max = node->value;
+            if (node->next) {
+                order->ascents += node->next->value > node->value;
+                order->descents += node->next->value < node->value;
+            }
+        }
+        break;
+    }
+}
+
+// Первый элемент очереди
+int queue_front(const Queue *q, int *value)
+{
+    if (q->size == 0)
+        return -1;
+    switch (q->backend) {
+    case QUEUE_BACKEND_RING:
+        *value = *ring_at(q, 0);
+        break;
+    case QUEUE_BACKEND_CHUNKED:
+        *value = *chunks_at(q, 0);
+        break;
+    default:
+        *value = q->head->value;
+        break;
+    }
+    return 0;
+}
+
+// Последний элемент очереди
+int queue_back(const Queue *q, int *value)
+{
+    if (q->size == 0)
+        return -1;
+    switch (q->backend) {
+    case QUEUE_BACKEND_RING:
+        *value = *ring_at(q, q->size - 1);
+        break;
+    case QUEUE_BACKEND_CHUNKED:
+        *value = q->chunks.tail->values[q->chunks.tail_off - 1];
+        break;
+    default:
+        *value = q->tail->value;
+        break;
+    }
+    return 0;
+}
+
+// Выгрузка значений очереди в массив
+void queue_to_array(const Queue *q, int *out)
+{
+    if (q->backend == QUEUE_BACKEND_RING) {
+        size_t first = q->ring.capacity - q->ring.head;
+        if (first > q->size)
+            first = q->size;
+        if (q->size) {
+            memcpy(out, q->ring.data + q->ring.head, first * sizeof(int));
+            memcpy(out + first, q->ring.data, (q->size - first) * sizeof(int));
+        }
+        return;
+    }
+
+    if (q->backend == QUEUE_BACKEND_CHUNKED) {
+        size_t off = q->chunks.head_off, left = q->size;
+        for (QueueChunk *chunk = q->chunks.head; left > 0; chunk = chunk->next) {
+            size_t part = QUEUE_CHUNK_CAPACITY - off;
+            if (part > left)
+                part = left;
+            memcpy(out, chunk->values + off, part * sizeof(int));
+            out += part;
+            left -= part;
+            off = 0;
+        }
+        return;
+    }
+
+    size_t i = 0;
+    for (QueueNode *node = q->head; node; node = node->next)
+        out[i++] = node->value;
+}
+
+// Название способа хранения
+const char* queue_backend_name(QueueBackend backend)
+{
+    switch (backend) {
+    case QUEUE_BACKEND_RING:
+        return "ring";
+    case QUEUE_BACKEND_CHUNKED:
+        return "chunked";
+    case QUEUE_BACKEND_LIST:
+    default:
+        return "list";
+    }
+}
+
+// Разбор названия способа хранения, 0 - успех
+int queue_backend_parse(const char *name, QueueBackend *backend)
+{
+    if (strcmp(name, "list") == 0) {
+        *backend = QUEUE_BACKEND_LIST;
+        return 0;
+    }
+    if (strcmp(name, "ring") == 0) {
+        *backend = QUEUE_BACKEND_RING;
+        return 0;
+    }
+    if (strcmp(name, "chunked") == 0) {
+        *backend = QUEUE_BACKEND_CHUNKED;
+        return 0;
+    }
+    return -1;
+}
+
+/* ==================== СОРТИРОВКИ МАССИВА ==================== */
+// Используются хранилищами без узлов (кольцевой буфер, список блоков)
+
+// Сортировка массива прямым выбором
+static void array_selection_sort(int *a, size_t n)
+{
+    for (size_t i = 0; i + 1 < n; i++) {
+        size_t min = i;
+        for (size_t j = i + 1; j < n; j++) {
+            if (a[j] < a[min])
+                min = j;
+        }
+        int tmp = a[i];
+        a[i] = a[min];
+        a[min] = tmp;
+    }
+}
+
+// Быстрая сортировка массива (разбиение Хоара, опорный - средний элемент)
+// Рекурсия только в меньшую часть, поэтому глубина стека O(log n)
+static void array_quick_sort(int *a, size_t n)
+{
+    while (n > 1) {
+        int pivot = a[(n - 1) / 2];
+        size_t i = 0, j = n - 1;
+        for (;;) {
+            while (a[i] < pivot)
+                i++;
+            while (a[j] > pivot)
+                j--;
+            if (i >= j)
+                break;
+            int tmp = a[i];
+            a[i] = a[j];
+            a[j] = tmp;
+            i++;
+            j--;
+        }
+        // [0, j] и [j + 1, n) - две части разбиения
+        size_t left = j + 1;
+        if (left < n - left) {
+            array_quick_sort(a, left);
+            a += left;
+            n -= left;
+        } else {
+            array_quick_sort(a + left, n - left);
+            n = left;
+        }
+    }
+}
+
+// Сортировка массива слиянием снизу вверх (устойчивая)
+// Слияния идут попеременно между массивом и буфером того же размера
+static void array_merge_sort(int *a, size_t n)
+{
+    if (n < 2)
+        return;
+
+    int *buf = (int *)malloc(n * sizeof(int));
+    if (!buf) {
+        array_quick_sort(a, n);
+        return;
+    }
+
+    int *src = a, *dst = buf;
+    for (size_t width = 1; width < n; width *= 2) {
+        for (size_t lo = 0; lo < n; lo += 2 * width) {
+            size_t mid = lo + width < n ? lo + width : n;
+            size_t hi = lo + 2 * width < n ? lo + 2 * width : n;
+            size_t i = lo, j = mid, k = lo;
+            while (i < mid && j < hi)
+                dst[k++] = (src[j] < src[i]) ? src[j++] : src[i++];
+            while (i < mid)
+                dst[k++] = src[i++];
+            while (j < hi)
+                dst[k++] = src[j++];
+        }
+        int *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != a)
+        memcpy(a, src, n * sizeof(int));
+    free(buf);
+}
+
+// Поразрядная сортировка массива (LSD, по байту за проход)
+// Гистограммы всех байтов считаются за один проход; проход, где все
+// элементы попадают в одну корзину, пропускается
+static void array_radix_sort(int *a, size_t n)
+{
+    if (n < 2)
+        return;
+
+    int *buf = (int *)malloc(n * sizeof(int));
+    if (!buf) {
+        array_quick_sort(a, n);
+        return;
+    }
+
+    size_t count[RADIX_PASSES][RADIX_BUCKETS];
+    memset(count, 0, sizeof(count));
+    for (size_t i = 0; i < n; i++) {
+        unsigned int key = RADIX_KEY(a[i]);
+        for (int pass = 0; pass < RADIX_PASSES; pass++)
+            count[pass][(key >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+    }
+
+    int *src = a, *dst = buf;
+    for (int pass = 0; pass < RADIX_PASSES; pass++) {
+        int shift = pass * RADIX_BITS;
+        if (count[pass][(RADIX_KEY(src[0]) >> shift) & (RADIX_BUCKETS - 1)] == n)
+            continue;
+
+        // Начальные позиции корзин
+        size_t pos[RADIX_BUCKETS];
+        size_t sum = 0;
+        for (int b = 0; b < RADIX_BUCKETS; b++) {
+            pos[b] = sum;
+            sum += count[pass][b];
+        }
+
+        for (size_t i = 0; i < n; i++)
+            dst[pos[(RADIX_KEY(src[i]) >> shift) & (RADIX_BUCKETS - 1)]++] = src[i];
+
+        int *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != a)
+        memcpy(a, src, n * sizeof(int));
+    free(buf);
+}
+
+// Ширина диапазона [min, max] (до 2^32, поэтому без переполнения int)
+static size_t value_range(int min, int max)
+{
+    return (size_t)((unsigned int)max - (unsigned int)min) + 1;
+}
+
+// Гистограмма значений из [min, max]: count[v - min]
+// NULL, если диапазон шире QUEUE_COUNTING_MAX_RANGE или не хватило памяти
+static size_t *counting_alloc(int min, int max)
+{
+    size_t range = value_range(min, max);
+    if (range > QUEUE_COUNTING_MAX_RANGE)
+        return NULL;
+    return (size_t *)calloc(range, sizeof(size_t));
+}
+
+// Сортировка подсчетом массива со значениями из [min, max]:
+// гистограмма за проход, затем значения выписываются по порядку
+// Возвращает -1, если гистограмму завести нельзя (массив не тронут)
+static int array_counting_sort_range(int *a, size_t n, int min, int max)
+{
+    size_t *count = counting_alloc(min, max);
+    if (!count)
+        return -1;
+
+    for (size_t i = 0; i < n; i++)
+        count[(unsigned int)a[i] - (unsigned int)min]++;
+
+    size_t range = value_range(min, max), k = 0;
+    for (size_t v = 0; v < range; v++) {
+        int value = (int)((long long)min + (long long)v);
+        for (size_t c = count[v]; c > 0; c--)
+            a[k++] = value;
+    }
+    free(count);
+    return 0;
+}
+
+// Сортировка подсчетом массива; при широком диапазоне - поразрядная
+static void array_counting_sort(int *a, size_t n)
+{
+    if (n < 2)
+        return;
+
+    int min = a[0], max = a[0];
+    for (size_t i = 1; i < n; i++) {
+        if (a[i] < min)
+            min = a[i];
+        if (a[i] > max)
+            max = a[i];
+    }
+    if (array_counting_sort_range(a, n, min, max) != 0)
+        array_radix_sort(a, n);
+}
+
+// Короткие серии добиваются вставками до этой длины
+#define ADAPTIVE_MIN_RUN 32
+// Глубина стека серий: при инвариантах TimSort ее хватает для любого size_t
+#define ADAPTIVE_MAX_RUNS 128
+
+// Длина естественной серии, начинающейся в a[0]; строго убывающая
+// серия разворачивается (строгость сохраняет устойчивость)
+static size_t array_find_run(int *a, size_t n)
+{
+    if (n < 2)
+        return n;
+
+    size_t len = 2;
+    if (a[1] < a[0]) {
+        while (len < n && a[len] < a[len - 1])
+            len++;
+        for (size_t i = 0, j = len - 1; i < j; i++, j--) {
+            int tmp = a[i];
+            a[i] = a[j];
+            a[j] = tmp;
+        }
+    } else {
+        while (len < n && a[len] >= a[len - 1])
+            len++;
+    }
+    return len;
 }
 
-// Освобождение всей памяти, занятой очередью
-void queue_free(Queue *q)
+// Вставками расширяет упорядоченные первые sorted элементов до n
+static void array_insertion_extend(int *a, size_t sorted, size_t n)
 {
-    QueueNode *cur = q->head;
-    while (cur) {
-        QueueNode *next = cur->next;
-        free(cur);
-        cur = next;
+    for (size_t i = sorted; i < n; i++) {
+        int v = a[i];
+        size_t j = i;
+        for (; j > 0 && a[j - 1] > v; j--)
+            a[j] = a[j - 1];
+        a[j] = v;
     }
-    
-    q->head = q->tail = NULL;
-    q->size = 0;
 }
 
-// Печать содержимого очереди
-void queue_print(const Queue *q)
+// Устойчивое слияние соседних серий a[0..mid) и a[mid..n) через buf
+// Уже упорядоченная граница (частый случай) не требует работы
+static void array_merge_adjacent(int *a, size_t mid, size_t n, int *buf)
 {
-    if (!q->head) {
-        printf("Очередь пуста\n");
+    if (a[mid - 1] <= a[mid])
         return;
-    }
 
-    QueueNode *node = q->head;
-    while (node) {
-        printf("%d", node->value);
-        node = node->next;
-        if (node)
-            printf(" ");
-    }
-    printf("\n");
+    memcpy(buf, a, mid * sizeof(int));
+    size_t i = 0, j = mid, k = 0;
+    while (i < mid && j < n)
+        a[k++] = (a[j] < buf[i]) ? a[j++] : buf[i++];
+    while (i < mid)
+        a[k++] = buf[i++];
 }
 
-// Изменение значения элемента по индексу
-// Индексация с нуля
-int queue_edit_at(Queue *q, size_t index, int new_value)
+// Адаптивная сортировка массива: естественные серии со стеком TimSort
+static void array_adaptive_sort(int *a, size_t n)
 {
-    if (index >= q->size)
-        return -1;
+    if (n < 2)
+        return;
 
-    QueueNode *node = q->head;
-    for (size_t i = 0; i < index; i++) {
-        node = node->next;
+    size_t first = array_find_run(a, n);
+    if (first == n)
+        return;     // Уже упорядочен (или был строго убывающим)
+
+    int *buf = (int *)malloc(n * sizeof(int));
+    if (!buf) {
+        array_quick_sort(a, n);
+        return;
     }
-    
-    node->value = new_value;
-    return 0;
+
+    size_t run_start[ADAPTIVE_MAX_RUNS], run_len[ADAPTIVE_MAX_RUNS];
+    size_t runs = 0, pos = 0;
+    while (pos < n) {
+        size_t len = pos == 0 ? first : array_find_run(a + pos, n - pos);
+        if (len < ADAPTIVE_MIN_RUN && pos + len < n) {
+            size_t target = n - pos < ADAPTIVE_MIN_RUN ? n - pos : ADAPTIVE_MIN_RUN;
+            array_insertion_extend(a + pos, len, target);
+            len = target;
+        }
+        run_start[runs] = pos;
+        run_len[runs] = len;
+        runs++;
+        pos += len;
+
+        // Инварианты TimSort: длины серий на стеке убывают быстрее Фибоначчи
+        while (runs > 1) {
+            size_t k = runs - 2;
+            if ((k > 0 && run_len[k - 1] <= run_len[k] + run_len[k + 1]) ||
+                (k > 1 && run_len[k - 2] <= run_len[k - 1] + run_len[k])) {
+                if (run_len[k - 1] < run_len[k + 1])
+                    k--;
+            } else if (run_len[k] > run_len[k + 1]) {
+                break;
+            }
+            array_merge_adjacent(a + run_start[k], run_len[k],
+                                 run_len[k] + run_len[k + 1], buf);
+            run_len[k] += run_len[k + 1];
+            for (size_t r = k + 1; r + 1 < runs; r++) {
+                run_start[r] = run_start[r + 1];
+                run_len[r] = run_len[r + 1];
+            }
+            runs--;
+        }
+    }
+
+    while (runs > 1) {
+        size_t k = runs - 2;
+        array_merge_adjacent(a + run_start[k], run_len[k], run_len[k] + run_len[k + 1], buf);
+        run_len[k] += run_len[k + 1];
+        runs--;
+    }
+    free(buf);
 }
 
-// Проверка, пуста ли очередь
-int queue_is_empty(const Queue *q)
+// Сортировка хранилища без узлов как массива
+// Кольцевой буфер сортируется на месте, список блоков - через временный массив
+// (без памяти под него - расческой прямо в блоках)
+// Возвращает 1, если очередь не является связным списком (и уже обработана)
+static int sort_as_array(Queue *q, void (*sort)(int *, size_t))
 {
-    return q->head == NULL;
+    switch (q->backend) {
+    case QUEUE_BACKEND_RING:
+        sort(ring_linearize(q), q->size);
+        return 1;
+    case QUEUE_BACKEND_CHUNKED: {
+        if (q->size < 2)
+            return 1;
+        int *a = (int *)malloc(q->size * sizeof(int));
+        if (!a) {
+            chunks_comb_sort(q);
+            return 1;
+        }
+        queue_to_array(q, a);
+        sort(a, q->size);
+        chunks_scatter(q, a);
+        free(a);
+        return 1;
+    }
+    case QUEUE_BACKEND_LIST:
+    default:
+        return 0;
+    }
 }
 
 // Сортировка очереди методом прямого выбора
 // Работает за O(n²), но прост в реализации
 void queue_selection_sort(Queue *q)
 {
+    if (sort_as_array(q, array_selection_sort))
+        return;
+    queue_invalidate_index(q);
+
     if (!q->head || !q->head->next)
         return;
 
@@ -157,89 +1524,644 @@ void queue_selection_sort(Queue *q)
     q->tail = new_tail;
 }
 
-// Вспомогательная функция для быстрой сортировки
-// Разделяет список относительно опорного элемента
-QueueNode* partition(QueueNode *head, QueueNode *tail, 
-                     QueueNode **new_head, QueueNode **new_tail)
+// Быстрая сортировка для очереди
+// В среднем работает за O(n log n), что быстрее сортировки выбором.
+// Список сортируется как массив (опорный - средний элемент, глубина
+// рекурсии O(log n)) и значения записываются обратно в те же узлы;
+// без памяти под массив - слиянием, которому она не нужна
+void queue_quick_sort(Queue *q)
 {
-    QueueNode *pivot = tail;
-    QueueNode *prev = NULL, *cur = head, *end = pivot;
-    
-    while (cur != pivot) {
-        if (cur->value < pivot->value) {
-            //перемещаем в левую часть
-            if (*new_head == NULL)
-                *new_head = cur;
-            prev = cur;
-            cur = cur->next;
-        } else {
-            // Перемещаем в правую часть (после опорного)
-            QueueNode *tmp = cur->next;
-            
-            if (prev)
-                prev->next = cur->next;
-            
-            cur->next = NULL;
-            end->next = cur;
-            end = cur;
-            cur = tmp;
+    if (sort_as_array(q, array_quick_sort))
+        return;
+
+    if (q->size < 2)
+        return;
+
+    int *a = (int *)malloc(q->size * sizeof(int));
+    if (!a) {
+        queue_merge_sort(q);
+        return;
+    }
+
+    queue_to_array(q, a);
+    array_quick_sort(a, q->size);
+
+    size_t i = 0;
+    for (QueueNode *node = q->head; node; node = node->next)
+        node->value = a[i++];
+    free(a);
+}
+
+// Сортировка слиянием снизу вверх без рекурсии
+// Узлы не копируются, а перецепляются; на каждом проходе соседние
+// отсортированные отрезки длины width сливаются в отрезки длины 2*width.
+// Время O(n log n) в худшем случае, дополнительная память O(1), устойчива.
+void queue_merge_sort(Queue *q)
+{
+    if (sort_as_array(q, array_merge_sort))
+        return;
+    queue_invalidate_index(q);
+
+    if (!q->head || !q->head->next)
+        return;
+
+    QueueNode *list = q->head;
+    for (size_t width = 1; ; width *= 2) {
+        QueueNode *left = list;
+        QueueNode *new_head = NULL, *new_tail = NULL;
+        size_t merges = 0;
+
+        while (left) {
+            merges++;
+
+            // Правый отрезок начинается через width узлов после левого
+            QueueNode *right = left;
+            size_t left_size = 0;
+            while (right && left_size < width) {
+                right = right->next;
+                left_size++;
+            }
+            size_t right_size = width;
+
+            // Слияние двух отрезков в конец нового списка
+            while (left_size > 0 || (right_size > 0 && right)) {
+                QueueNode *node;
+                if (left_size == 0) {
+                    node = right;
+                    right = right->next;
+                    right_size--;
+                } else if (right_size == 0 || !right || left->value <= right->value) {
+                    node = left;
+                    left = left->next;
+                    left_size--;
+                } else {
+                    node = right;
+                    right = right->next;
+                    right_size--;
+                }
+
+                if (new_tail)
+                    new_tail->next = node;
+                else
+                    new_head = node;
+                new_tail = node;
+            }
+
+            left = right;
+        }
+
+        new_tail->next = NULL;
+        list = new_head;
+
+        // Один отрезок на весь список - сортировка закончена
+        if (merges <= 1) {
+            q->head = new_head;
+            q->tail = new_tail;
+            return;
         }
     }
-    
-    if (*new_head == NULL)
-        *new_head = pivot;
-    
-    *new_tail = end;
-    
-    return pivot;
 }
 
-// Рекурсивная часть быстрой сортировки
-QueueNode* quick_sort_recursive(QueueNode *head, QueueNode *tail)
+// Отрезок списка для адаптивной сортировки
+typedef struct ListRun {
+    QueueNode *head;
+    QueueNode *tail;
+    size_t len;
+} ListRun;
+
+// Отрезает от list естественную серию; строго убывающая серия
+// переворачивается по ходу (узлы ставятся в начало отрезка)
+static ListRun list_take_run(QueueNode **list)
 {
-    if (!head || head == tail)
-        return head;
-    
-    QueueNode *new_head = NULL, *new_tail = NULL;
-    
-    QueueNode *pivot = partition(head, tail, &new_head, &new_tail);
-    
-    // Сортируем левую часть (если она есть)
-    if (new_head != pivot) {
-        QueueNode *tmp = new_head;
-        while (tmp->next != pivot)
-            tmp = tmp->next;
-        tmp->next = NULL;
-        
-        new_head = quick_sort_recursive(new_head, tmp);
-        
-        tmp = get_tail(new_head);
-        tmp->next = pivot;
+    QueueNode *node = *list;
+    ListRun run = { node, node, 1 };
+    QueueNode *next = node->next;
+
+    if (next && next->value < node->value) {
+        run.tail->next = NULL;
+        while (next && next->value < run.head->value) {
+            QueueNode *after = next->next;
+            next->next = run.head;
+            run.head = next;
+            run.len++;
+            next = after;
+        }
+    } else {
+        while (next && next->value >= run.tail->value) {
+            run.tail = next;
+            run.len++;
+            next = next->next;
+        }
+        run.tail->next = NULL;
     }
-    
-    // Сортируем правую часть
-    pivot->next = quick_sort_recursive(pivot->next, new_tail);
-    
-    return new_head;
+
+    *list = next;
+    return run;
+}
+
+// Вставка узла в упорядоченный отрезок (после равных - устойчиво)
+static void list_run_insert(ListRun *run, QueueNode *node)
+{
+    run->len++;
+    if (node->value >= run->tail->value) {
+        run->tail->next = node;
+        node->next = NULL;
+        run->tail = node;
+        return;
+    }
+    if (node->value < run->head->value) {
+        node->next = run->head;
+        run->head = node;
+        return;
+    }
+    QueueNode *prev = run->head;
+    while (prev->next->value <= node->value)
+        prev = prev->next;
+    node->next = prev->next;
+    prev->next = node;
 }
 
-// Получить последний элемент списка
-QueueNode* get_tail(QueueNode *head)
+// Устойчивое слияние соседних отрезков a и b (b шел после a)
+static ListRun list_run_merge(ListRun a, ListRun b)
 {
-    while (head && head->next)
-        head = head->next;
-    return head;
+    ListRun out = { NULL, NULL, a.len + b.len };
+
+    // Отрезки уже идут по порядку: достаточно сцепить
+    if (a.tail->value <= b.head->value) {
+        a.tail->next = b.head;
+        out.head = a.head;
+        out.tail = b.tail;
+        return out;
+    }
+
+    QueueNode dummy;
+    QueueNode *tail = &dummy;
+    QueueNode *x = a.head, *y = b.head;
+    while (x && y) {
+        if (y->value < x->value) {
+            tail->next = y;
+            y = y->next;
+        } else {
+            tail->next = x;
+            x = x->next;
+        }
+        tail = tail->next;
+    }
+    if (x) {
+        tail->next = x;
+        out.tail = a.tail;
+    } else {
+        tail->next = y;
+        out.tail = b.tail;
+    }
+    out.head = dummy.next;
+    return out;
 }
 
-// Быстрая сортировка для очереди
-// В среднем работает за O(n log n), что быстрее сортировки выбором
-void queue_quick_sort(Queue *q)
+// Слияние серий k и k+1 на стеке
+static void list_stack_merge(ListRun *stack, size_t *runs, size_t k)
+{
+    stack[k] = list_run_merge(stack[k], stack[k + 1]);
+    for (size_t r = k + 1; r + 1 < *runs; r++)
+        stack[r] = stack[r + 1];
+    (*runs)--;
+}
+
+// Адаптивная сортировка слиянием естественных серий (в духе TimSort)
+// Упорядоченный и обратно упорядоченный список - один проход O(n),
+// почти упорядоченный - несколько сцеплений, иначе O(n log n).
+// Узлы только перецепляются, дополнительной памяти не нужно.
+void queue_adaptive_sort(Queue *q)
 {
+    if (sort_as_array(q, array_adaptive_sort))
+        return;
+    queue_invalidate_index(q);
+
     if (!q->head || !q->head->next)
         return;
-    
-    q->head = quick_sort_recursive(q->head, q->tail);
-    q->tail = get_tail(q->head);
+
+    ListRun stack[ADAPTIVE_MAX_RUNS];
+    size_t runs = 0;
+    QueueNode *list = q->head;
+
+    while (list) {
+        ListRun run = list_take_run(&list);
+        while (run.len < ADAPTIVE_MIN_RUN && list) {
+            QueueNode *node = list;
+            list = list->next;
+            list_run_insert(&run, node);
+        }
+        stack[runs++] = run;
+
+        // Инварианты TimSort: длины серий на стеке убывают быстрее Фибоначчи
+        while (runs > 1) {
+            size_t k = runs - 2;
+            if ((k > 0 && stack[k - 1].len <= stack[k].len + stack[k + 1].len) ||
+                (k > 1 && stack[k - 2].len <= stack[k - 1].len + stack[k].len)) {
+                if (stack[k - 1].len < stack[k + 1].len)
+                    k--;
+            } else if (stack[k].len > stack[k + 1].len) {
+                break;
+            }
+            list_stack_merge(stack, &runs, k);
+        }
+    }
+
+    while (runs > 1)
+        list_stack_merge(stack, &runs, runs - 2);
+
+    q->head = stack[0].head;
+    q->tail = stack[0].tail;
+}
+
+// Поразрядная сортировка (LSD radix sort)
+// За проход узлы раскладываются по 256 корзинам по очередному байту ключа
+// и сцепляются обратно; значения не копируются. Раскладка устойчива,
+// поэтому после 4 проходов список упорядочен. Время O(n), память O(1).
+void queue_radix_sort(Queue *q)
+{
+    if (sort_as_array(q, array_radix_sort))
+        return;
+    queue_invalidate_index(q);
+
+    if (!q->head || !q->head->next)
+        return;
+
+    QueueNode *bucket_head[RADIX_BUCKETS];
+    QueueNode *bucket_tail[RADIX_BUCKETS];
+    QueueNode *list = q->head;
+    QueueNode *last = q->tail;
+
+    for (int pass = 0; pass < RADIX_PASSES; pass++) {
+        int shift = pass * RADIX_BITS;
+        memset(bucket_head, 0, sizeof(bucket_head));
+
+        for (QueueNode *node = list; node; node = node->next) {
+            unsigned int b = (RADIX_KEY(node->value) >> shift) & (RADIX_BUCKETS - 1);
+            if (bucket_head[b])
+                bucket_tail[b]->next = node;
+            else
+                bucket_head[b] = node;
+            bucket_tail[b] = node;
+        }
+
+        // Сцепляем непустые корзины по порядку
+        list = last = NULL;
+        for (int b = 0; b < RADIX_BUCKETS; b++) {
+            if (!bucket_head[b])
+                continue;
+            if (last)
+                last->next = bucket_head[b];
+            else
+                list = bucket_head[b];
+            last = bucket_tail[b];
+        }
+        last->next = NULL;
+    }
+
+    q->head = list;
+    q->tail = last;
+}
+
+// Сортировка подсчетом списка со значениями из [min, max]: узлы
+// остаются на местах, в них по порядку переписываются значения
+static int list_counting_sort(Queue *q, int min, int max)
+{
+    size_t *count = counting_alloc(min, max);
+    if (!count)
+        return -1;
+
+    for (QueueNode *node = q->head; node; node = node->next)
+        count[(unsigned int)node->value - (unsigned int)min]++;
+
+    size_t v = 0;
+    for (QueueNode *node = q->head; node; node = node->next) {
+        while (count[v] == 0)
+            v++;
+        count[v]--;
+        node->value = (int)((long long)min + (long long)v);
+    }
+    free(count);
+    return 0;
+}
+
+// Сортировка подсчетом (counting sort): O(n + k), где k - ширина
+// диапазона значений. Связи списка не меняются. Если диапазон шире
+// QUEUE_COUNTING_MAX_RANGE или нет памяти на гистограмму - поразрядная сортировка
+void queue_counting_sort(Queue *q)
+{
+    if (sort_as_array(q, array_counting_sort))
+        return;
+
+    if (q->size < 2)
+        return;
+
+    int min = q->head->value, max = min;
+    for (QueueNode *node = q->head->next; node; node = node->next) {
+        if (node->value < min)
+            min = node->value;
+        if (node->value > max)
+            max = node->value;
+    }
+    if (list_counting_sort(q, min, max) != 0)
+        queue_radix_sort(q);
+}
+
+// Сортировка через непрерывный массив: значения собираются из узлов,
+// сортируются векторным ядром (simd_sort.h) и записываются обратно
+// в те же узлы по порядку, так что связи списка не меняются
+void queue_simd_sort(Queue *q)
+{
+    if (sort_as_array(q, simd_sort_ints))
+        return;
+
+    if (q->size < 2)
+        return;
+
+    int *a = (int *)malloc(q->size * sizeof(int));
+    if (!a) {
+        queue_merge_sort(q);
+        return;
+    }
+
+    queue_to_array(q, a);
+    simd_sort_ints(a, q->size);
+
+    size_t i = 0;
+    for (QueueNode *node = q->head; node; node = node->next)
+        node->value = a[i++];
+    free(a);
+}
+
+// Пороги автовыбора; по умолчанию - замеры на типичной машине,
+// профиль --calibrate заменяет их замерами на текущей
+#define AUTO_DEFAULT_TUNING {                                             \
+    {AUTO_SMALL_SIZE, AUTO_RUN_RATIO, AUTO_COUNTING_LIST_RATIO, 0},        \
+    {AUTO_SMALL_SIZE, AUTO_RUN_RATIO, AUTO_COUNTING_ARRAY_RATIO, 0},       \
+}
+
+static QueueSortTuning sort_tuning = AUTO_DEFAULT_TUNING;
+
+void queue_sort_tuning_default(QueueSortTuning *tuning)
+{
+    static const QueueSortTuning defaults = AUTO_DEFAULT_TUNING;
+    *tuning = defaults;
+}
+
+void queue_sort_tuning_get(QueueSortTuning *tuning)
+{
+    *tuning = sort_tuning;
+}
+
+int queue_sort_tuning_set(const QueueSortTuning *tuning)
+{
+    const QueueSortThresholds *kinds[] = {&tuning->list, &tuning->array};
+    for (int k = 0; k < 2; k++) {
+        if (kinds[k]->run_ratio == 0 || !(kinds[k]->counting_ratio >= 0))
+            return -1;
+    }
+    sort_tuning = *tuning;
+    return 0;
+}
+
+// Автоматический выбор сортировки по одному проходу по данным:
+// упорядоченная очередь не трогается; маленькая и состоящая из длинных
+// серий (в любую сторону) сортируется адаптивно. Узкий диапазон значений -
+// подсчетом: проход по гистограмме тогда не дороже прохода по данным
+// (для массивов порог ниже - их поразрядная сортировка быстрее, чем
+// у списка). Остальное: массивы - поразрядно, большой список на
+// нескольких ядрах - параллельно, иначе через массив, так как четыре
+// прохода поразрядной сортировки по разбросанным узлам обходятся дороже.
+// Все пороги берутся из sort_tuning
+void queue_sort_auto(Queue *q)
+{
+    QueueOrder order;
+    queue_count_order(q, &order);
+    if (order.descents == 0)
+        return;
+
+    size_t runs = order.ascents < order.descents ? order.ascents : order.descents;
+    size_t range = value_range(order.min, order.max);
+    const QueueSortThresholds *th = q->backend == QUEUE_BACKEND_LIST ?
+                                    &sort_tuning.list : &sort_tuning.array;
+    if (q->size <= th->small_size || runs < q->size / th->run_ratio) {
+        queue_adaptive_sort(q);
+    } else if ((double)range <= (double)q->size * th->counting_ratio &&
+               range <= QUEUE_COUNTING_MAX_RANGE) {
+        // Для списка диапазон уже известен - второй проход по узлам не нужен
+        if (q->backend != QUEUE_BACKEND_LIST ||
+            list_counting_sort(q, order.min, order.max) != 0)
+            queue_counting_sort(q);
+    } else if (q->backend == QUEUE_BACKEND_LIST) {
+        if (th->parallel_size > 0 && q->size >= th->parallel_size)
+            queue_parallel_sort(q, 0);
+        else
+            queue_simd_sort(q);
+    } else {
+        queue_radix_sort(q);
+    }
+}
+
+/* ==================== K НАИМЕНЬШИХ ==================== */
+
+// Просеивание вниз в max-куче heap[0..count)
+static void max_heap_sift_down(int *heap, size_t count, size_t i)
+{
+    int v = heap[i];
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= count)
+            break;
+        if (child + 1 < count && heap[child + 1] > heap[child])
+            child++;
+        if (heap[child] <= v)
+            break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = v;
+}
+
+// Ограниченная max-куча k наименьших ключей (в корне - наибольший из них)
+typedef struct TopKHeap {
+    int *keys;
+    size_t count;
+    size_t k;
+} TopKHeap;
+
+// Ключи a[i] ^ flip: при flip = -1 (~v) порядок обратный, без переполнения
+// Пока куча не полна, ключ добавляется, потом ключ меньше корня его
+// заменяет: O(log k) на значение, но большинство отсеивается сравнением
+static void top_k_offer(TopKHeap *h, const int *a, size_t n, int flip)
+{
+    for (size_t i = 0; i < n; i++) {
+        int key = a[i] ^ flip;
+        if (h->count < h->k) {
+            size_t j = h->count++;
+            while (j > 0 && h->keys[(j - 1) / 2] < key) {
+                h->keys[j] = h->keys[(j - 1) / 2];
+                j = (j - 1) / 2;
+            }
+            h->keys[j] = key;
+        } else if (key < h->keys[0]) {
+            h->keys[0] = key;
+            max_heap_sift_down(h->keys, h->k, 0);
+        }
+    }
+}
+
+// Один проход по очереди с кучей на k ключей прямо в out
+static size_t queue_top_k_keys(const Queue *q, size_t k, int flip, int *out)
+{
+    if (k > q->size)
+        k = q->size;
+    if (k == 0)
+        return 0;
+
+    TopKHeap h = {out, 0, k};
+    switch (q->backend) {
+    case QUEUE_BACKEND_RING: {
+        size_t first = q->ring.capacity - q->ring.head;
+        if (first > q->size)
+            first = q->size;
+        top_k_offer(&h, q->ring.data + q->ring.head, first, flip);
+        top_k_offer(&h, q->ring.data, q->size - first, flip);
+        break;
+    }
+    case QUEUE_BACKEND_CHUNKED: {
+        size_t off = q->chunks.head_off, left = q->size;
+        for (QueueChunk *chunk = q->chunks.head; left > 0; chunk = chunk->next) {
+            size_t n = QUEUE_CHUNK_CAPACITY - off;
+            if (n > left)
+                n = left;
+            top_k_offer(&h, chunk->values + off, n, flip);
+            left -= n;
+            off = 0;
+        }
+        break;
+    }
+    case QUEUE_BACKEND_LIST:
+    default:
+        for (const QueueNode *node = q->head; node; node = node->next)
+            top_k_offer(&h, &node->value, 1, flip);
+        break;
+    }
+
+    simd_sort_ints(out, k);
+    for (size_t i = 0; i < k; i++)
+        out[i] ^= flip;
+    return k;
+}
+
+// k наименьших значений по возрастанию за O(n log k), очередь не меняется
+size_t queue_top_k(const Queue *q, size_t k, int *out)
+{
+    return queue_top_k_keys(q, k, 0, out);
+}
+
+// k наибольших значений по убыванию
+size_t queue_top_k_largest(const Queue *q, size_t k, int *out)
+{
+    return queue_top_k_keys(q, k, -1, out);
+}
+
+// Выбор кучей: max-куча из a[0..k), меньшие значения из хвоста
+// вытесняют ее корень; после вызова a[0..k) - k наименьших. O(n log k)
+static void array_heap_select(int *a, size_t n, size_t k)
+{
+    for (size_t i = k / 2; i-- > 0;)
+        max_heap_sift_down(a, k, i);
+    for (size_t i = k; i < n; i++) {
+        if (a[i] < a[0]) {
+            int tmp = a[0];
+            a[0] = a[i];
+            a[i] = tmp;
+            max_heap_sift_down(a, k, 0);
+        }
+    }
+}
+
+// Introselect: после вызова a[0..k) - k наименьших (в любом порядке)
+// Быстрый выбор разбиением Хоара (как в array_quick_sort) продолжается
+// только в части, где проходит граница k: в среднем O(n). Если разбиений
+// больше SELECT_DEPTH_FACTOR * log2(n) (неудачные опорные), остаток
+// доделывает выбор кучей, так что худший случай - O(n log k)
+static void array_select(int *a, size_t n, size_t k)
+{
+    int depth = 0;
+    for (size_t m = n; m > 1; m >>= 1)
+        depth += SELECT_DEPTH_FACTOR;
+
+    while (k > 0 && k < n) {
+        if (depth-- == 0) {
+            array_heap_select(a, n, k);
+            return;
+        }
+        int pivot = a[(n - 1) / 2];
+        size_t i = 0, j = n - 1;
+        for (;;) {
+            while (a[i] < pivot)
+                i++;
+            while (a[j] > pivot)
+                j--;
+            if (i >= j)
+                break;
+            int tmp = a[i];
+            a[i] = a[j];
+            a[j] = tmp;
+            i++;
+            j--;
+        }
+        // [0, j] не больше опорного, [j + 1, n) - не меньше
+        size_t left = j + 1;
+        if (k <= left) {
+            n = left;
+        } else {
+            a += left;
+            n -= left;
+            k -= left;
+        }
+    }
+}
+
+// Частичная сортировка: первые k элементов - k наименьших по возрастанию,
+// остальные - в произвольном порядке. O(n + k log k) в среднем.
+// Значения обрабатываются в массиве (кольцевой буфер - на месте) и
+// записываются обратно, связи списка не меняются
+void queue_partial_sort(Queue *q, size_t k)
+{
+    if (q->size < 2 || k == 0)
+        return;
+    if (k >= q->size) {
+        queue_sort_auto(q);
+        return;
+    }
+
+    // Кольцевой буфер выстраивается на месте и памяти не требует
+    if (q->backend == QUEUE_BACKEND_RING) {
+        int *a = ring_linearize(q);
+        array_select(a, q->size, k);
+        simd_sort_ints(a, k);
+        return;
+    }
+
+    int *a = (int *)malloc(q->size * sizeof(int));
+    if (!a) {
+        queue_merge_sort(q);
+        return;
+    }
+    queue_to_array(q, a);
+    array_select(a, q->size, k);
+    simd_sort_ints(a, k);
+
+    if (q->backend == QUEUE_BACKEND_CHUNKED) {
+        chunks_scatter(q, a);
+    } else {
+        size_t i = 0;
+        for (QueueNode *node = q->head; node; node = node->next)
+            node->value = a[i++];
+    }
+    free(a);
 }
 
 Queue* queue_copy(const Queue *q)
@@ -248,17 +2170,56 @@ Queue* queue_copy(const Queue *q)
     if (!copy)
         return NULL;
     
-    queue_init(copy);
+    queue_init_backend(copy, q->backend);
+    copy->index.stride = q->index.stride;
+    if (q->size == 0)
+        return copy;
     
-    QueueNode *node = q->head;
-    while (node) {
-        if (queue_push(copy, node->value) != 0) {
-            queue_free(copy);
+    if (q->backend == QUEUE_BACKEND_RING) {
+        copy->ring.data = (int *)mem_alloc(&copy->mem, q->size * sizeof(int));
+        if (!copy->ring.data) {
             free(copy);
             return NULL;
         }
-        node = node->next;
+        queue_to_array(q, copy->ring.data);
+        copy->ring.capacity = q->size;
+        copy->size = q->size;
+        return copy;
+    }
+    
+    if (q->backend == QUEUE_BACKEND_CHUNKED) {
+        size_t off = q->chunks.head_off, left = q->size;
+        for (QueueChunk *chunk = q->chunks.head; left > 0; chunk = chunk->next) {
+            size_t part = QUEUE_CHUNK_CAPACITY - off;
+            if (part > left)
+                part = left;
+            if (chunks_push_array(copy, chunk->values + off, part) != 0) {
+                queue_free(copy);
+                free(copy);
+                return NULL;
+            }
+            left -= part;
+            off = 0;
+        }
+        return copy;
+    }
+    
+    // Все узлы копии берутся из одного блока
+    QueueNode *run = pool_alloc_run(&copy->pool, &copy->mem, q->size);
+    if (!run) {
+        free(copy);
+        return NULL;
+    }
+    
+    size_t i = 0;
+    for (QueueNode *node = q->head; node; node = node->next, i++) {
+        run[i].value = node->value;
+        run[i].next = &run[i + 1];
     }
+    run[i - 1].next = NULL;
     
+    copy->head = run;
+    copy->tail = &run[i - 1];
+    copy->size = q->size;
     return copy;
 }
\ No newline at end of file
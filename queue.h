@@ -2,6 +2,7 @@
 #define QUEUE_H 
 
 #include <stddef.h>  // Для типа size_t (беззнаковый целый тип для хранения размеров)
+#include <stdio.h>   // Для FILE в queue_write
 
 //ОЧЕРЕДЬ (QUEUE) - структура данных типа FIFO (First In, First Out)
 
@@ -13,45 +14,260 @@ typedef struct QueueNode {
 } QueueNode;
 
 
+//БЛОК ПУЛА УЗЛОВ (QueueSlab)
+//Узлы выделяются не по одному, а целыми блоками; блоки связаны в список
+typedef struct QueueSlab {
+    struct QueueSlab *next;       // Предыдущий выделенный блок
+    size_t capacity;              // Сколько узлов помещается в блок
+    size_t used;                  // Сколько узлов уже выдано из блока
+    QueueNode nodes[];            // Сами узлы
+} QueueSlab;
+
+
+//ПУЛ УЗЛОВ (QueueNodePool)
+//Освобожденные узлы попадают в список свободных и переиспользуются
+typedef struct QueueNodePool {
+    QueueSlab *slabs;             // Список блоков (последний выделенный - первый)
+    QueueNode *free_list;         // Список свободных узлов
+    size_t next_capacity;         // Размер следующего блока
+} QueueNodePool;
+
+
+//СПОСОБ ХРАНЕНИЯ ЭЛЕМЕНТОВ (QueueBackend)
+//Выбирается при инициализации, набор операций для всех один и тот же
+typedef enum QueueBackend {
+    QUEUE_BACKEND_LIST = 0,       // Связный список узлов (по умолчанию)
+    QUEUE_BACKEND_RING,           // Растущий кольцевой буфер
+    QUEUE_BACKEND_CHUNKED         // Список блоков по QUEUE_CHUNK_CAPACITY значений
+} QueueBackend;
+
+
+//КОЛЬЦЕВОЙ БУФЕР (QueueRing)
+typedef struct QueueRing {
+    int *data;                    // Непрерывный массив значений
+    size_t capacity;              // Размер массива
+    size_t head;                  // Индекс первого элемента очереди
+} QueueRing;
+
+
+//БЛОК ЗНАЧЕНИЙ (QueueChunk)
+#define QUEUE_CHUNK_CAPACITY 128
+typedef struct QueueChunk {
+    struct QueueChunk *next;              // Следующий блок
+    int values[QUEUE_CHUNK_CAPACITY];     // Значения блока
+} QueueChunk;
+
+
+//СПИСОК БЛОКОВ (QueueChunks)
+//Элементы лежат в head->values[head_off] ... tail->values[tail_off - 1]
+typedef struct QueueChunks {
+    QueueChunk *head;             // Блок с первым элементом
+    QueueChunk *tail;             // Блок с последним элементом
+    size_t head_off;              // Позиция первого элемента в head
+    size_t tail_off;              // Число занятых позиций в tail
+    QueueChunk *spare;            // Освободившийся блок для повторного использования
+} QueueChunks;
+
+
+//ПОЗИЦИОННЫЙ ИНДЕКС СПИСКА (QueueIndex)
+//Указатели на каждый stride-й узел: доступ по номеру за O(stride) шагов.
+//Поддерживается при push/pop, после сортировок строится заново при
+//первом обращении по номеру
+typedef struct QueueIndex {
+    QueueNode **nodes;            // nodes[e] - узел с позицией e * stride
+    size_t stride;                // Шаг индекса (0 - индекс выключен)
+    size_t first;                 // Первая запись, узел которой еще в очереди
+    size_t count;                 // Число записей
+    size_t capacity;              // Размер массива nodes
+    size_t base;                  // Позиция первого элемента очереди
+    int valid;                    // 0 - индекс нужно построить заново
+} QueueIndex;
+
+
+//УЧЕТ ПАМЯТИ ОЧЕРЕДИ (QueueMemStats)
+//Считается память хранилища: блоки пула, кольцевой буфер, блоки значений,
+//массив индекса. Временные буферы сортировок и сама структура Queue не входят
+typedef struct QueueMemStats {
+    size_t allocs;                // Вызовов malloc/realloc
+    size_t frees;                 // Вызовов free
+    size_t bytes_live;            // Занято сейчас
+    size_t bytes_peak;            // Наибольшее значение bytes_live
+} QueueMemStats;
+
+
 //СТРУКТУРА ОЧЕРЕДИ (Queue)
+//head/tail/pool используются списком, ring - кольцевым буфером,
+//chunks - списком блоков
 typedef struct Queue {
     QueueNode *head;  // Указатель на первый элемент (для извлечения)
     QueueNode *tail;  // Указатель на последний элемент (для добавления)
-    unsigned int size;      // Количество элементов в очереди
+    size_t size;            // Количество элементов в очереди
+    QueueBackend backend;   // Способ хранения элементов
+    QueueNodePool pool;     // Пул, из которого берутся узлы этой очереди
+    QueueRing ring;         // Хранилище для QUEUE_BACKEND_RING
+    QueueChunks chunks;     // Хранилище для QUEUE_BACKEND_CHUNKED
+    QueueIndex index;       // Позиционный индекс списка (необязательный)
+    QueueMemStats mem;      // Учет выделенной памяти
 } Queue;
 
+//ПОРОГИ АВТОВЫБОРА СОРТИРОВКИ (QueueSortTuning)
+//Отдельно для списка и для хранилищ-массивов (ring, chunked)
+typedef struct QueueSortThresholds {
+    size_t small_size;        // До этого размера - адаптивная сортировка
+    size_t run_ratio;         // Средняя серия длиннее - адаптивная (не 0)
+    double counting_ratio;    // Подсчет при диапазоне значений до size * counting_ratio
+    size_t parallel_size;     // С этого размера - параллельная (0 - никогда; только список)
+} QueueSortThresholds;
+
+typedef struct QueueSortTuning {
+    QueueSortThresholds list;
+    QueueSortThresholds array;
+} QueueSortTuning;
+
+//ВРЕМЯ ПАРАЛЛЕЛЬНОЙ СОРТИРОВКИ ПО ПОТОКАМ (QueueParallelStats)
+#define QUEUE_MAX_THREADS 64
+typedef struct QueueParallelStats {
+    int threads;                              // Сколько потоков реально работало
+    double sort_seconds[QUEUE_MAX_THREADS];   // Сортировка своего подсписка
+    double cut_seconds[QUEUE_MAX_THREADS];    // Разрезание по разделителям
+    double merge_seconds[QUEUE_MAX_THREADS];  // Слияние своего диапазона значений
+    double total_seconds;                     // Общее время
+} QueueParallelStats;
+
 /* ==================== БАЗОВЫЕ ОПЕРАЦИИ ==================== */
 
-//Инициализация очереди
+//Инициализация очереди (связный список)
 void queue_init(Queue *q);
 
+//Инициализация очереди с выбранным способом хранения
+void queue_init_backend(Queue *q, QueueBackend backend);
+
 //Добавление элемента в конец очереди (enqueue)
 int queue_push(Queue *q, int value);
 
 //Извлечение элемента из начала очереди (dequeue)
 int queue_pop(Queue *q, int *value);
 
-//Освобождение памяти, занятой очередью
+//Добавление n значений из массива в конец очереди одним проходом
+//(0 - успех, -1 - нехватка памяти, очередь при этом не меняется)
+int queue_push_n(Queue *q, const int *values, size_t n);
+
+//Извлечение до n значений из начала очереди в out; возвращает их число
+size_t queue_pop_n(Queue *q, int *out, size_t n);
+
+//Освобождение памяти, занятой очередью (блоки пула освобождаются целиком)
 void queue_free(Queue *q);
 
 //Вывод содержимого очереди в стандартный поток вывода
 void queue_print(const Queue *q);
 
+//Запись значений одной строкой в поток (пустая очередь - ничего);
+//0 - успех, -1 - ошибка записи
+int queue_write(const Queue *q, FILE *stream);
+
 /* ==================== ДОПОЛНИТЕЛЬНЫЕ ОПЕРАЦИИ ==================== */
 
 //Изменение значения элемента по индексу
 int queue_edit_at(Queue *q, size_t index, int new_value);
 
+//Чтение значения элемента по индексу (0 - успех, -1 - неверный индекс)
+//Может построить позиционный индекс, поэтому очередь не const
+int queue_get_at(Queue *q, size_t index, int *value);
+
+//Позиционный индекс для queue_edit_at/queue_get_at у связного списка:
+//запоминается каждый stride-й узел (stride = 0 - шаг по умолчанию, 64)
+void queue_enable_index(Queue *q, size_t stride);
+void queue_disable_index(Queue *q);
+
+//Сброс индекса после прямого перецепления узлов (строится лениво)
+void queue_invalidate_index(Queue *q);
+
 //Сортировка очереди методом прямого выбора (selection sort)
 void queue_selection_sort(Queue *q);
 
 //Сортировка очереди методом быстрой сортировки (quick sort)
 void queue_quick_sort(Queue *q);
 
+//Сортировка очереди слиянием (merge sort): O(n log n) в худшем случае,
+//без рекурсии, устойчивая; узлы списка перецепляются без копирования
+void queue_merge_sort(Queue *q);
+
+//Поразрядная сортировка (LSD radix sort) по байтам значения: 4 прохода,
+//O(n); узлы перецепляются по корзинам, отрицательные числа поддерживаются
+void queue_radix_sort(Queue *q);
+
+//Адаптивная сортировка слиянием естественных серий (в духе TimSort):
+//упорядоченные и обратно упорядоченные данные - за O(n), почти
+//упорядоченные - за несколько слияний, в худшем случае O(n log n)
+void queue_adaptive_sort(Queue *q);
+
+//Сортировка подсчетом (counting sort): O(n + k) для k различных возможных
+//значений; в узлы по порядку переписываются значения. При диапазоне шире
+//QUEUE_COUNTING_MAX_RANGE (гистограмма 32 МБ) - поразрядная
+#define QUEUE_COUNTING_MAX_RANGE (1u << 22)
+void queue_counting_sort(Queue *q);
+
+//Сортировка сбором значений в массив, векторной сортировкой (AVX2/SSE4.1,
+//выбирается по CPUID) и обратной записью в узлы по порядку
+void queue_simd_sort(Queue *q);
+
+//Автоматический выбор алгоритма по данным (один проход перед сортировкой):
+//упорядоченная очередь не сортируется, маленькая или почти упорядоченная -
+//адаптивной сортировкой, с узким диапазоном значений (не шире size, для
+//массивов - size / 4) - подсчетом, остальные - поразрядной (список -
+//векторной или, если задан порог, параллельной)
+void queue_sort_auto(Queue *q);
+
+//Пороги queue_sort_auto: общие для всех очередей, задаются при запуске
+//(профиль --calibrate) до начала сортировок. set возвращает -1, если
+//run_ratio == 0 или counting_ratio < 0 (пороги не меняются)
+void queue_sort_tuning_default(QueueSortTuning *tuning);
+void queue_sort_tuning_get(QueueSortTuning *tuning);
+int queue_sort_tuning_set(const QueueSortTuning *tuning);
+
+//k наименьших значений очереди по возрастанию (k наибольших - по убыванию)
+//в out (не меньше k элементов) без сортировки всей очереди: один проход
+//с ограниченной кучей, O(n log k). Очередь не меняется.
+//Возвращает число записанных значений (меньшее из k и размера)
+size_t queue_top_k(const Queue *q, size_t k, int *out);
+size_t queue_top_k_largest(const Queue *q, size_t k, int *out);
+
+//Частичная сортировка: первые k элементов становятся k наименьшими
+//по возрастанию, порядок остальных не определен (introselect + сортировка
+//k элементов, O(n + k log k)); при k >= size - полная сортировка
+void queue_partial_sort(Queue *q, size_t k);
+
+//Параллельная сортировка (queue_parallel.c): список делится на подсписки,
+//потоки сортируют их слиянием, затем каждый поток k-путевым слиянием
+//собирает свой диапазон значений; узлы перецепляются без копирования.
+//threads <= 0 - по числу ядер
+void queue_parallel_sort(Queue *q, int threads);
+
+//То же с замером времени каждого потока (stats может быть NULL)
+void queue_parallel_sort_timed(Queue *q, int threads, QueueParallelStats *stats);
+
+//Число доступных ядер (не больше QUEUE_MAX_THREADS)
+int queue_default_threads(void);
+
 //Проверка очереди на пустоту
 int queue_is_empty(const Queue *q);
 
-QueueNode* get_tail(QueueNode *head);
+//Байт памяти хранилища на один элемент (0 для пустой очереди)
+double queue_bytes_per_element(const Queue *q);
+
+//Упорядочена ли очередь по неубыванию (один проход, O(n))
+int queue_is_sorted(const Queue *q);
+
+//Первый и последний элементы без извлечения (0 - успех, -1 - очередь пуста)
+int queue_front(const Queue *q, int *value);
+int queue_back(const Queue *q, int *value);
+
+//Копирование значений очереди по порядку в массив out (размер не меньше q->size)
+void queue_to_array(const Queue *q, int *out);
+
+//Название способа хранения и разбор названия ("list", "ring", "chunked")
+const char* queue_backend_name(QueueBackend backend);
+int queue_backend_parse(const char *name, QueueBackend *backend);
 
 Queue* queue_copy(const Queue *q);
 
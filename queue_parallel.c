@@ -0,0 +1,325 @@
+#include "queue.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Меньше этого числа элементов на поток распараллеливать невыгодно
+#define PARALLEL_MIN_PER_THREAD 4096
+// Сколько значений каждый поток отдает в выборку для разделителей
+#define PARALLEL_SAMPLES_PER_THREAD 64
+
+// Отрезок списка (голова и хвост)
+typedef struct ListPart {
+    QueueNode *head;
+    QueueNode *tail;
+    size_t size;
+} ListPart;
+
+// Ключ разбиения на диапазоны: значение, затем номер подсписка и место
+// в нем. Все ключи различны, поэтому равные значения тоже расходятся
+// по разным диапазонам, а не собираются в одном
+typedef struct SplitKey {
+    int value;
+    int part;
+    size_t pos;
+} SplitKey;
+
+// Общее состояние параллельной сортировки
+typedef struct ParallelSort {
+    int threads;
+    ListPart parts[QUEUE_MAX_THREADS];                      // Подсписок каждого потока
+    SplitKey samples[QUEUE_MAX_THREADS * PARALLEL_SAMPLES_PER_THREAD];
+    SplitKey splitters[QUEUE_MAX_THREADS];                  // threads - 1 разделителей
+    ListPart segments[QUEUE_MAX_THREADS][QUEUE_MAX_THREADS]; // [подсписок][диапазон]
+    ListPart merged[QUEUE_MAX_THREADS];                     // Результат по диапазонам
+    QueueParallelStats *stats;
+} ParallelSort;
+
+// Аргумент потока: общее состояние и номер потока
+typedef struct ParallelTask {
+    ParallelSort *ps;
+    int id;
+} ParallelTask;
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Добавление узла в конец отрезка
+static void part_append(ListPart *part, QueueNode *node)
+{
+    if (part->tail)
+        part->tail->next = node;
+    else
+        part->head = node;
+    part->tail = node;
+    part->size++;
+}
+
+// Запуск fn во всех потоках и ожидание их завершения
+// Поток с номером 0 выполняется в вызывающем потоке
+static void run_phase(ParallelSort *ps, void *(*fn)(void *))
+{
+    pthread_t handles[QUEUE_MAX_THREADS];
+    ParallelTask tasks[QUEUE_MAX_THREADS];
+    int started[QUEUE_MAX_THREADS];
+
+    for (int i = 0; i < ps->threads; i++) {
+        tasks[i].ps = ps;
+        tasks[i].id = i;
+    }
+    for (int i = 1; i < ps->threads; i++)
+        started[i] = pthread_create(&handles[i], NULL, fn, &tasks[i]) == 0;
+
+    fn(&tasks[0]);
+
+    // Если поток не удалось создать, его часть выполняется здесь же
+    for (int i = 1; i < ps->threads; i++) {
+        if (started[i])
+            pthread_join(handles[i], NULL);
+        else
+            fn(&tasks[i]);
+    }
+}
+
+/* ==================== ФАЗА 1: ЛОКАЛЬНАЯ СОРТИРОВКА ==================== */
+
+// Поток сортирует свой подсписок и берет из него равномерную выборку
+static void *phase_sort(void *arg)
+{
+    ParallelTask *task = (ParallelTask *)arg;
+    ParallelSort *ps = task->ps;
+    ListPart *part = &ps->parts[task->id];
+    double start = now_seconds();
+
+    Queue sub;
+    queue_init(&sub);
+    sub.head = part->head;
+    sub.tail = part->tail;
+    sub.size = part->size;
+    queue_merge_sort(&sub);
+    part->head = sub.head;
+    part->tail = sub.tail;
+
+    SplitKey *samples = &ps->samples[task->id * PARALLEL_SAMPLES_PER_THREAD];
+    size_t step = part->size / PARALLEL_SAMPLES_PER_THREAD, pos = 0;
+    QueueNode *node = part->head;
+    for (int s = 0; s < PARALLEL_SAMPLES_PER_THREAD; s++) {
+        samples[s].value = node->value;
+        samples[s].part = task->id;
+        samples[s].pos = pos;
+        for (size_t k = 0; k < step && node->next; k++, pos++)
+            node = node->next;
+    }
+
+    ps->stats->sort_seconds[task->id] = now_seconds() - start;
+    return NULL;
+}
+
+/* ==================== ФАЗА 2: РАЗРЕЗАНИЕ ПО РАЗДЕЛИТЕЛЯМ ==================== */
+
+static int compare_keys(const SplitKey *a, const SplitKey *b)
+{
+    if (a->value != b->value)
+        return (a->value > b->value) - (a->value < b->value);
+    if (a->part != b->part)
+        return (a->part > b->part) - (a->part < b->part);
+    return (a->pos > b->pos) - (a->pos < b->pos);
+}
+
+// Отсортированный подсписок режется на диапазоны:
+// диапазон j - ключи в [splitters[j-1], splitters[j])
+static void *phase_cut(void *arg)
+{
+    ParallelTask *task = (ParallelTask *)arg;
+    ParallelSort *ps = task->ps;
+    ListPart *segments = ps->segments[task->id];
+    double start = now_seconds();
+
+    memset(segments, 0, ps->threads * sizeof(ListPart));
+
+    int range = 0;
+    SplitKey key = {0, task->id, 0};
+    QueueNode *node = ps->parts[task->id].head;
+    while (node) {
+        QueueNode *next = node->next;
+        key.value = node->value;
+        while (range < ps->threads - 1 && compare_keys(&key, &ps->splitters[range]) >= 0)
+            range++;
+        part_append(&segments[range], node);
+        node = next;
+        key.pos++;
+    }
+    for (int j = 0; j < ps->threads; j++) {
+        if (segments[j].tail)
+            segments[j].tail->next = NULL;
+    }
+
+    ps->stats->cut_seconds[task->id] = now_seconds() - start;
+    return NULL;
+}
+
+/* ==================== ФАЗА 3: K-ПУТЕВОЕ СЛИЯНИЕ ==================== */
+
+// Просеивание вниз в min-куче узлов
+static void heap_sift_down(QueueNode **heap, int count, int i)
+{
+    for (;;) {
+        int smallest = i;
+        int left = 2 * i + 1, right = 2 * i + 2;
+        if (left < count && heap[left]->value < heap[smallest]->value)
+            smallest = left;
+        if (right < count && heap[right]->value < heap[smallest]->value)
+            smallest = right;
+        if (smallest == i)
+            return;
+        QueueNode *tmp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = tmp;
+        i = smallest;
+    }
+}
+
+// Поток j сливает диапазон j всех подсписков через кучу из их голов
+static void *phase_merge(void *arg)
+{
+    ParallelTask *task = (ParallelTask *)arg;
+    ParallelSort *ps = task->ps;
+    ListPart *out = &ps->merged[task->id];
+    double start = now_seconds();
+
+    QueueNode *heap[QUEUE_MAX_THREADS];
+    int count = 0;
+    for (int i = 0; i < ps->threads; i++) {
+        if (ps->segments[i][task->id].head)
+            heap[count++] = ps->segments[i][task->id].head;
+    }
+    for (int i = count / 2 - 1; i >= 0; i--)
+        heap_sift_down(heap, count, i);
+
+    memset(out, 0, sizeof(*out));
+    while (count > 0) {
+        QueueNode *node = heap[0];
+        if (node->next) {
+            heap[0] = node->next;
+        } else {
+            heap[0] = heap[--count];
+        }
+        heap_sift_down(heap, count, 0);
+        part_append(out, node);
+    }
+    if (out->tail)
+        out->tail->next = NULL;
+
+    ps->stats->merge_seconds[task->id] = now_seconds() - start;
+    return NULL;
+}
+
+static int compare_samples(const void *a, const void *b)
+{
+    return compare_keys((const SplitKey *)a, (const SplitKey *)b);
+}
+
+// Число потоков по умолчанию - число доступных ядер
+int queue_default_threads(void)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1)
+        return 1;
+    if (cpus > QUEUE_MAX_THREADS)
+        return QUEUE_MAX_THREADS;
+    return (int)cpus;
+}
+
+// Параллельная сортировка с замером времени каждого потока
+void queue_parallel_sort_timed(Queue *q, int threads, QueueParallelStats *stats)
+{
+    QueueParallelStats local_stats;
+    if (!stats)
+        stats = &local_stats;
+    memset(stats, 0, sizeof(*stats));
+    double start = now_seconds();
+
+    if (threads <= 0)
+        threads = queue_default_threads();
+    if (threads > QUEUE_MAX_THREADS)
+        threads = QUEUE_MAX_THREADS;
+    if ((size_t)threads > q->size / PARALLEL_MIN_PER_THREAD)
+        threads = (int)(q->size / PARALLEL_MIN_PER_THREAD);
+
+    // Хранилища без узлов и маленькие очереди сортируются в одном потоке
+    if (q->backend != QUEUE_BACKEND_LIST || threads < 2) {
+        stats->threads = 1;
+        if (q->backend == QUEUE_BACKEND_LIST)
+            queue_merge_sort(q);
+        else
+            queue_simd_sort(q);
+        stats->sort_seconds[0] = stats->total_seconds = now_seconds() - start;
+        return;
+    }
+
+    ParallelSort *ps = (ParallelSort *)malloc(sizeof(ParallelSort));
+    if (!ps) {
+        stats->threads = 1;
+        queue_merge_sort(q);
+        stats->sort_seconds[0] = stats->total_seconds = now_seconds() - start;
+        return;
+    }
+    ps->threads = threads;
+    ps->stats = stats;
+    stats->threads = threads;
+
+    // Разбиение списка на threads подсписков почти равной длины
+    QueueNode *node = q->head;
+    for (int i = 0; i < threads; i++) {
+        size_t count = q->size / threads + ((size_t)i < q->size % threads);
+        ListPart *part = &ps->parts[i];
+        part->head = node;
+        part->size = count;
+        for (size_t k = 1; k < count; k++)
+            node = node->next;
+        part->tail = node;
+        node = node->next;
+        part->tail->next = NULL;
+    }
+
+    run_phase(ps, phase_sort);
+
+    // Разделители диапазонов - равномерно взятые значения общей выборки
+    size_t num_samples = (size_t)threads * PARALLEL_SAMPLES_PER_THREAD;
+    qsort(ps->samples, num_samples, sizeof(SplitKey), compare_samples);
+    for (int j = 1; j < threads; j++)
+        ps->splitters[j - 1] = ps->samples[j * num_samples / threads];
+
+    run_phase(ps, phase_cut);
+    run_phase(ps, phase_merge);
+
+    // Сцепление диапазонов по порядку
+    QueueNode *head = NULL, *tail = NULL;
+    for (int j = 0; j < threads; j++) {
+        if (!ps->merged[j].head)
+            continue;
+        if (tail)
+            tail->next = ps->merged[j].head;
+        else
+            head = ps->merged[j].head;
+        tail = ps->merged[j].tail;
+    }
+    q->head = head;
+    q->tail = tail;
+    queue_invalidate_index(q);
+
+    free(ps);
+    stats->total_seconds = now_seconds() - start;
+}
+
+// Параллельная сортировка; threads <= 0 - по числу ядер
+void queue_parallel_sort(Queue *q, int threads)
+{
+    queue_parallel_sort_timed(q, threads, NULL);
+}
@@ -0,0 +1,357 @@
+#ifndef QUEUE_TYPED_H
+#define QUEUE_TYPED_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+//ТИПИЗИРОВАННЫЕ ОЧЕРЕДИ (генератор в заголовке)
+//QUEUE_DEFINE(name, type, less) создает тип name - очередь значений type
+//в связном списке на пуле узлов (как у Queue со способом хранения list) -
+//и функции name_init, name_push, ..., name_merge_sort, name_quick_sort.
+//less(a, b) - макрос или inline-функция "a строго меньше b"; сравнение
+//подставляется в циклы сортировок при компиляции, без вызова по указателю.
+//Все функции static inline, поэтому QUEUE_DEFINE можно вызывать в любом
+//числе файлов (каждый получает свою копию используемых функций).
+//
+//Пример: записи с 64-битным ключом и полезной нагрузкой
+//  typedef struct Record { int64_t key; char payload[24]; } Record;
+//  #define RECORD_LESS(a, b) ((a).key < (b).key)
+//  QUEUE_DEFINE(RecordQueue, Record, RECORD_LESS)
+//  ...
+//  RecordQueue q;
+//  RecordQueue_init(&q);
+//  RecordQueue_push(&q, r);
+//  RecordQueue_merge_sort(&q);     // устойчиво: равные ключи не меняются местами
+
+#define QUEUE_TYPED_FIRST_SLAB 64       // Размер первого блока пула (в узлах)
+#define QUEUE_TYPED_MAX_SLAB   65536    // Дальше блоки перестают расти
+
+//Сравнение для чисел и других типов с оператором <
+#define QUEUE_LESS(a, b) ((a) < (b))
+
+#define QUEUE_DEFINE(name, type, less)                                        \
+    QUEUE_DEFINE_TYPES(name, type)                                            \
+    QUEUE_DEFINE_BASIC(name, type, less)                                      \
+    QUEUE_DEFINE_SORTS(name, type, less)
+
+/* ==================== ТИПЫ ==================== */
+
+#define QUEUE_DEFINE_TYPES(name, type)                                        \
+typedef struct name##Node {                                                   \
+    struct name##Node *next;                                                  \
+    type value;                                                               \
+} name##Node;                                                                 \
+                                                                              \
+typedef struct name##Slab {                                                   \
+    struct name##Slab *next;    /* Предыдущий выделенный блок */              \
+    size_t capacity;            /* Сколько узлов помещается в блок */         \
+    size_t used;                /* Сколько узлов уже выдано */                \
+    name##Node nodes[];                                                       \
+} name##Slab;                                                                 \
+                                                                              \
+typedef struct name {                                                         \
+    name##Node *head;                                                         \
+    name##Node *tail;                                                         \
+    size_t size;                                                              \
+    name##Slab *slabs;          /* Блоки пула (последний - первый) */         \
+    name##Node *free_list;      /* Освобожденные узлы */                      \
+    size_t next_capacity;       /* Размер следующего блока */                 \
+} name;
+
+/* ==================== ОСНОВНЫЕ ОПЕРАЦИИ ==================== */
+/* Коды возврата как у Queue: 0 - успех, -1 - нет памяти, очередь пуста */
+/* или индекс вне очереди */
+
+#define QUEUE_DEFINE_BASIC(name, type, less)                                  \
+static inline void name##_init(name *q)                                       \
+{                                                                             \
+    q->head = q->tail = NULL;                                                 \
+    q->size = 0;                                                              \
+    q->slabs = NULL;                                                          \
+    q->free_list = NULL;                                                      \
+    q->next_capacity = QUEUE_TYPED_FIRST_SLAB;                                \
+}                                                                             \
+                                                                              \
+/* Освобождение всех блоков пула: O(число блоков) */                          \
+static inline void name##_free(name *q)                                       \
+{                                                                             \
+    name##Slab *slab = q->slabs;                                              \
+    while (slab) {                                                            \
+        name##Slab *next = slab->next;                                        \
+        free(slab);                                                           \
+        slab = next;                                                          \
+    }                                                                         \
+    name##_init(q);                                                           \
+}                                                                             \
+                                                                              \
+/* count подряд идущих узлов; одиночный узел - сначала из свободных */        \
+static inline name##Node *name##_alloc_nodes(name *q, size_t count)           \
+{                                                                             \
+    if (count == 1 && q->free_list) {                                         \
+        name##Node *node = q->free_list;                                      \
+        q->free_list = node->next;                                            \
+        return node;                                                          \
+    }                                                                         \
+    name##Slab *slab = q->slabs;                                              \
+    if (!slab || slab->capacity - slab->used < count) {                       \
+        size_t capacity = q->next_capacity < count ? count : q->next_capacity;\
+        slab = (name##Slab *)malloc(sizeof(name##Slab) +                      \
+                                    capacity * sizeof(name##Node));           \
+        if (!slab)                                                            \
+            return NULL;                                                      \
+        slab->capacity = capacity;                                            \
+        slab->used = 0;                                                       \
+        slab->next = q->slabs;                                                \
+        q->slabs = slab;                                                      \
+        if (q->next_capacity < QUEUE_TYPED_MAX_SLAB)                          \
+            q->next_capacity *= 2;                                            \
+    }                                                                         \
+    name##Node *nodes = &slab->nodes[slab->used];                             \
+    slab->used += count;                                                      \
+    return nodes;                                                             \
+}                                                                             \
+                                                                              \
+static inline int name##_push(name *q, type value)                            \
+{                                                                             \
+    name##Node *node = name##_alloc_nodes(q, 1);                              \
+    if (!node)                                                                \
+        return -1;                                                            \
+    node->value = value;                                                      \
+    node->next = NULL;                                                        \
+    if (q->tail)                                                              \
+        q->tail->next = node;                                                 \
+    else                                                                      \
+        q->head = node;                                                       \
+    q->tail = node;                                                           \
+    q->size++;                                                                \
+    return 0;                                                                 \
+}                                                                             \
+                                                                              \
+/* Добавление n значений одним выделением узлов */                            \
+static inline int name##_push_n(name *q, const type *values, size_t n)        \
+{                                                                             \
+    if (n == 0)                                                               \
+        return 0;                                                             \
+    name##Node *run = name##_alloc_nodes(q, n);                               \
+    if (!run)                                                                 \
+        return -1;                                                            \
+    for (size_t i = 0; i < n; i++) {                                          \
+        run[i].value = values[i];                                             \
+        run[i].next = i + 1 < n ? &run[i + 1] : NULL;                         \
+    }                                                                         \
+    if (q->tail)                                                              \
+        q->tail->next = run;                                                  \
+    else                                                                      \
+        q->head = run;                                                        \
+    q->tail = &run[n - 1];                                                    \
+    q->size += n;                                                             \
+    return 0;                                                                 \
+}                                                                             \
+                                                                              \
+static inline int name##_pop(name *q, type *value)                            \
+{                                                                             \
+    name##Node *node = q->head;                                               \
+    if (!node)                                                                \
+        return -1;                                                            \
+    if (value)                                                                \
+        *value = node->value;                                                 \
+    q->head = node->next;                                                     \
+    if (!q->head)                                                             \
+        q->tail = NULL;                                                       \
+    node->next = q->free_list;                                                \
+    q->free_list = node;                                                      \
+    q->size--;                                                                \
+    return 0;                                                                 \
+}                                                                             \
+                                                                              \
+static inline int name##_front(const name *q, type *value)                    \
+{                                                                             \
+    if (!q->head)                                                             \
+        return -1;                                                            \
+    *value = q->head->value;                                                  \
+    return 0;                                                                 \
+}                                                                             \
+                                                                              \
+static inline int name##_is_empty(const name *q)                              \
+{                                                                             \
+    return q->size == 0;                                                      \
+}                                                                             \
+                                                                              \
+/* Узел по индексу (проход от головы) или NULL */                             \
+static inline name##Node *name##_node_at(const name *q, size_t index)         \
+{                                                                             \
+    if (index >= q->size)                                                     \
+        return NULL;                                                          \
+    name##Node *node = q->head;                                               \
+    while (index-- > 0)                                                       \
+        node = node->next;                                                    \
+    return node;                                                              \
+}                                                                             \
+                                                                              \
+static inline int name##_get_at(const name *q, size_t index, type *value)     \
+{                                                                             \
+    name##Node *node = name##_node_at(q, index);                              \
+    if (!node)                                                                \
+        return -1;                                                            \
+    *value = node->value;                                                     \
+    return 0;                                                                 \
+}                                                                             \
+                                                                              \
+static inline int name##_edit_at(name *q, size_t index, type value)           \
+{                                                                             \
+    name##Node *node = name##_node_at(q, index);                              \
+    if (!node)                                                                \
+        return -1;                                                            \
+    node->value = value;                                                      \
+    return 0;                                                                 \
+}                                                                             \
+                                                                              \
+/* Копирование значений в массив out (не меньше size элементов) */            \
+static inline void name##_to_array(const name *q, type *out)                  \
+{                                                                             \
+    for (const name##Node *node = q->head; node; node = node->next)           \
+        *out++ = node->value;                                                 \
+}                                                                             \
+                                                                              \
+/* Копия очереди (узлы копии - одним блоком); NULL - нет памяти */            \
+static inline name *name##_copy(const name *q)                                \
+{                                                                             \
+    name *copy = (name *)malloc(sizeof(name));                                \
+    if (!copy)                                                                \
+        return NULL;                                                          \
+    name##_init(copy);                                                        \
+    if (q->size == 0)                                                         \
+        return copy;                                                          \
+    name##Node *run = name##_alloc_nodes(copy, q->size);                      \
+    if (!run) {                                                               \
+        free(copy);                                                           \
+        return NULL;                                                          \
+    }                                                                         \
+    size_t i = 0;                                                             \
+    for (const name##Node *node = q->head; node; node = node->next, i++) {    \
+        run[i].value = node->value;                                           \
+        run[i].next = &run[i + 1];                                            \
+    }                                                                         \
+    run[q->size - 1].next = NULL;                                             \
+    copy->head = run;                                                         \
+    copy->tail = &run[q->size - 1];                                           \
+    copy->size = q->size;                                                     \
+    return copy;                                                              \
+}                                                                             \
+                                                                              \
+static inline int name##_is_sorted(const name *q)                             \
+{                                                                             \
+    for (const name##Node *node = q->head; node && node->next;                \
+         node = node->next) {                                                 \
+        if (less(node->next->value, node->value))                             \
+            return 0;                                                         \
+    }                                                                         \
+    return 1;                                                                 \
+}
+
+/* ==================== СОРТИРОВКИ ==================== */
+
+#define QUEUE_DEFINE_SORTS(name, type, less)                                  \
+/* Сортировка слиянием снизу вверх: узлы перецепляются, O(n log n)         */ \
+/* в худшем случае, дополнительная память O(1), устойчива                  */ \
+static inline void name##_merge_sort(name *q)                                 \
+{                                                                             \
+    if (!q->head || !q->head->next)                                           \
+        return;                                                               \
+    name##Node *list = q->head, *last = NULL;                                 \
+    for (size_t width = 1; ; width *= 2) {                                    \
+        name##Node *left = list, *new_head = NULL;                            \
+        size_t merges = 0;                                                    \
+        last = NULL;                                                          \
+        while (left) {                                                        \
+            merges++;                                                         \
+            name##Node *right = left;                                         \
+            size_t left_size = 0, right_size = width;                         \
+            while (right && left_size < width) {                              \
+                right = right->next;                                          \
+                left_size++;                                                  \
+            }                                                                 \
+            while (left_size > 0 || (right_size > 0 && right)) {              \
+                name##Node *node;                                             \
+                if (left_size == 0 ||                                         \
+                    (right_size > 0 && right &&                               \
+                     less(right->value, left->value))) {                      \
+                    node = right;                                             \
+                    right = right->next;                                      \
+                    right_size--;                                             \
+                } else {                                                      \
+                    node = left;                                              \
+                    left = left->next;                                        \
+                    left_size--;                                              \
+                }                                                             \
+                if (last)                                                     \
+                    last->next = node;                                        \
+                else                                                          \
+                    new_head = node;                                          \
+                last = node;                                                  \
+            }                                                                 \
+            left = right;                                                     \
+        }                                                                     \
+        last->next = NULL;                                                    \
+        list = new_head;                                                      \
+        if (merges <= 1)                                                      \
+            break;                                                            \
+    }                                                                         \
+    q->head = list;                                                           \
+    q->tail = last;                                                           \
+}                                                                             \
+                                                                              \
+/* Быстрая сортировка массива (разбиение Хоара, опорный - средний),        */ \
+/* рекурсия только в меньшую часть                                         */ \
+static inline void name##_array_quick_sort(type *a, size_t n)                 \
+{                                                                             \
+    while (n > 1) {                                                           \
+        type pivot = a[(n - 1) / 2];                                          \
+        size_t i = 0, j = n - 1;                                              \
+        for (;;) {                                                            \
+            while (less(a[i], pivot))                                         \
+                i++;                                                          \
+            while (less(pivot, a[j]))                                         \
+                j--;                                                          \
+            if (i >= j)                                                       \
+                break;                                                        \
+            type tmp = a[i];                                                  \
+            a[i] = a[j];                                                      \
+            a[j] = tmp;                                                       \
+            i++;                                                              \
+            j--;                                                              \
+        }                                                                     \
+        size_t left = j + 1;                                                  \
+        if (left < n - left) {                                                \
+            name##_array_quick_sort(a, left);                                 \
+            a += left;                                                        \
+            n -= left;                                                        \
+        } else {                                                              \
+            name##_array_quick_sort(a + left, n - left);                      \
+            n = left;                                                         \
+        }                                                                     \
+    }                                                                         \
+}                                                                             \
+                                                                              \
+/* Быстрая сортировка через массив: значения собираются из узлов,          */ \
+/* сортируются и записываются обратно по порядку (связи не меняются).      */ \
+/* Неустойчива; без памяти на массив - слиянием                            */ \
+static inline void name##_quick_sort(name *q)                                 \
+{                                                                             \
+    if (q->size < 2)                                                          \
+        return;                                                               \
+    type *a = (type *)malloc(q->size * sizeof(type));                         \
+    if (!a) {                                                                 \
+        name##_merge_sort(q);                                                 \
+        return;                                                               \
+    }                                                                         \
+    name##_to_array(q, a);                                                    \
+    name##_array_quick_sort(a, q->size);                                      \
+    size_t i = 0;                                                             \
+    for (name##Node *node = q->head; node; node = node->next)                 \
+        node->value = a[i++];                                                 \
+    free(a);                                                                  \
+}
+
+#endif /* QUEUE_TYPED_H */
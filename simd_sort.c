@@ -0,0 +1,311 @@
+#include "simd_sort.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_SORT_X86 1
+#include <immintrin.h>
+#endif
+
+// Длина массива округляется вверх до кратной 8, хвост заполняется INT_MAX
+#define SIMD_PAD 8
+
+// Ядра упорядочены по возможностям: более сильное можно понизить
+typedef enum SortKernel {
+    KERNEL_UNKNOWN = 0,
+    KERNEL_SCALAR,
+    KERNEL_SSE4,
+    KERNEL_AVX2
+} SortKernel;
+
+static SortKernel active_kernel = KERNEL_UNKNOWN;
+
+// Слияние двух отсортированных отрезков a и b в out
+typedef void (*MergeRuns)(const int *a, size_t la, const int *b, size_t lb, int *out);
+
+/* ==================== СКАЛЯРНОЕ ЯДРО ==================== */
+
+static void scalar_merge_runs(const int *a, size_t la, const int *b, size_t lb, int *out)
+{
+    size_t i = 0, j = 0;
+    while (i < la && j < lb)
+        *out++ = (b[j] < a[i]) ? b[j++] : a[i++];
+    while (i < la)
+        *out++ = a[i++];
+    while (j < lb)
+        *out++ = b[j++];
+}
+
+// Проходы слияния снизу вверх, начиная с отрезков длины width
+// Возвращает буфер (src или dst), в котором оказался результат
+static int* merge_passes(int *src, int *dst, size_t n, size_t width, MergeRuns merge)
+{
+    for (; width < n; width *= 2) {
+        for (size_t lo = 0; lo < n; lo += 2 * width) {
+            size_t mid = lo + width < n ? lo + width : n;
+            size_t hi = lo + 2 * width < n ? lo + 2 * width : n;
+            if (mid == hi)
+                memcpy(dst + lo, src + lo, (hi - lo) * sizeof(int));
+            else
+                merge(src + lo, mid - lo, src + mid, hi - mid, dst + lo);
+        }
+        int *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+    return src;
+}
+
+// Запасной вариант: обычная сортировка слиянием, затем вставками при нехватке памяти
+static void scalar_sort(int *a, size_t n)
+{
+    int *buf = (int *)malloc(n * sizeof(int));
+    if (!buf) {
+        for (size_t i = 1; i < n; i++) {
+            int v = a[i];
+            size_t j = i;
+            for (; j > 0 && a[j - 1] > v; j--)
+                a[j] = a[j - 1];
+            a[j] = v;
+        }
+        return;
+    }
+
+    int *sorted = merge_passes(a, buf, n, 1, scalar_merge_runs);
+    if (sorted != a)
+        memcpy(a, sorted, n * sizeof(int));
+    free(buf);
+}
+
+#ifdef SIMD_SORT_X86
+
+/* ==================== ЯДРО AVX2 (8 x int32) ==================== */
+
+// Сравнение-обмен с соседом по перестановке perm:
+// в разрядах mask остается максимум, в остальных - минимум
+#define AVX2_CMPSWAP(v, perm, mask) do {                     \
+        __m256i p_ = (perm);                                 \
+        __m256i lo_ = _mm256_min_epi32((v), p_);             \
+        __m256i hi_ = _mm256_max_epi32((v), p_);             \
+        (v) = _mm256_blend_epi32(lo_, hi_, (mask));          \
+    } while (0)
+
+#define AVX2_SWAP1(v) _mm256_shuffle_epi32((v), _MM_SHUFFLE(2, 3, 0, 1))
+#define AVX2_SWAP2(v) _mm256_shuffle_epi32((v), _MM_SHUFFLE(1, 0, 3, 2))
+#define AVX2_SWAP4(v) _mm256_permute2x128_si256((v), (v), 0x01)
+
+// Упорядочивание битонической последовательности из 8 элементов
+#define AVX2_BITONIC_CLEAN(v) do {                           \
+        AVX2_CMPSWAP(v, AVX2_SWAP4(v), 0xF0);                \
+        AVX2_CMPSWAP(v, AVX2_SWAP2(v), 0xCC);                \
+        AVX2_CMPSWAP(v, AVX2_SWAP1(v), 0xAA);                \
+    } while (0)
+
+// Битоническая сортировка 8 элементов внутри регистра
+#define AVX2_SORT8(v) do {                                   \
+        AVX2_CMPSWAP(v, AVX2_SWAP1(v), 0x66);                \
+        AVX2_CMPSWAP(v, AVX2_SWAP2(v), 0x3C);                \
+        AVX2_CMPSWAP(v, AVX2_SWAP1(v), 0x5A);                \
+        AVX2_BITONIC_CLEAN(v);                               \
+    } while (0)
+
+// Слияние двух отсортированных регистров: lo - 8 меньших, hi - 8 больших
+#define AVX2_MERGE8(lo, hi, reverse) do {                    \
+        __m256i r_ = _mm256_permutevar8x32_epi32((hi), (reverse)); \
+        __m256i mn_ = _mm256_min_epi32((lo), r_);            \
+        (hi) = _mm256_max_epi32((lo), r_);                   \
+        (lo) = mn_;                                          \
+        AVX2_BITONIC_CLEAN(lo);                              \
+        AVX2_BITONIC_CLEAN(hi);                              \
+    } while (0)
+
+// Сортировка каждого блока из 8 элементов (n кратно 8)
+__attribute__((target("avx2")))
+static void avx2_sort_blocks(int *a, size_t n)
+{
+    for (size_t i = 0; i < n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(a + i));
+        AVX2_SORT8(v);
+        _mm256_storeu_si256((__m256i *)(a + i), v);
+    }
+}
+
+// Векторное слияние отрезков, длины которых кратны 8:
+// в регистре hi всегда лежат 8 наибольших из уже прочитанных значений,
+// следующий блок берется из того отрезка, чей очередной элемент меньше
+__attribute__((target("avx2")))
+static void avx2_merge_runs(const int *a, size_t la, const int *b, size_t lb, int *out)
+{
+    const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    __m256i lo = _mm256_loadu_si256((const __m256i *)a);
+    __m256i hi = _mm256_loadu_si256((const __m256i *)b);
+    size_t i = 8, j = 8;
+
+    for (;;) {
+        AVX2_MERGE8(lo, hi, reverse);
+        _mm256_storeu_si256((__m256i *)out, lo);
+        out += 8;
+
+        if (i < la && (j >= lb || a[i] <= b[j])) {
+            lo = _mm256_loadu_si256((const __m256i *)(a + i));
+            i += 8;
+        } else if (j < lb) {
+            lo = _mm256_loadu_si256((const __m256i *)(b + j));
+            j += 8;
+        } else {
+            break;
+        }
+    }
+    _mm256_storeu_si256((__m256i *)out, hi);
+}
+
+/* ==================== ЯДРО SSE4.1 (4 x int32) ==================== */
+
+#define SSE4_CMPSWAP(v, perm, mask) do {                     \
+        __m128i p_ = (perm);                                 \
+        __m128i lo_ = _mm_min_epi32((v), p_);                \
+        __m128i hi_ = _mm_max_epi32((v), p_);                \
+        (v) = _mm_castps_si128(_mm_blend_ps(_mm_castsi128_ps(lo_), \
+                                            _mm_castsi128_ps(hi_), (mask))); \
+    } while (0)
+
+#define SSE4_SWAP1(v) _mm_shuffle_epi32((v), _MM_SHUFFLE(2, 3, 0, 1))
+#define SSE4_SWAP2(v) _mm_shuffle_epi32((v), _MM_SHUFFLE(1, 0, 3, 2))
+#define SSE4_REVERSE(v) _mm_shuffle_epi32((v), _MM_SHUFFLE(0, 1, 2, 3))
+
+#define SSE4_BITONIC_CLEAN(v) do {                           \
+        SSE4_CMPSWAP(v, SSE4_SWAP2(v), 0xC);                 \
+        SSE4_CMPSWAP(v, SSE4_SWAP1(v), 0xA);                 \
+    } while (0)
+
+#define SSE4_SORT4(v) do {                                   \
+        SSE4_CMPSWAP(v, SSE4_SWAP1(v), 0x6);                 \
+        SSE4_BITONIC_CLEAN(v);                               \
+    } while (0)
+
+#define SSE4_MERGE4(lo, hi) do {                             \
+        __m128i r_ = SSE4_REVERSE(hi);                       \
+        __m128i mn_ = _mm_min_epi32((lo), r_);               \
+        (hi) = _mm_max_epi32((lo), r_);                      \
+        (lo) = mn_;                                          \
+        SSE4_BITONIC_CLEAN(lo);                              \
+        SSE4_BITONIC_CLEAN(hi);                              \
+    } while (0)
+
+__attribute__((target("sse4.1")))
+static void sse4_sort_blocks(int *a, size_t n)
+{
+    for (size_t i = 0; i < n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(a + i));
+        SSE4_SORT4(v);
+        _mm_storeu_si128((__m128i *)(a + i), v);
+    }
+}
+
+__attribute__((target("sse4.1")))
+static void sse4_merge_runs(const int *a, size_t la, const int *b, size_t lb, int *out)
+{
+    __m128i lo = _mm_loadu_si128((const __m128i *)a);
+    __m128i hi = _mm_loadu_si128((const __m128i *)b);
+    size_t i = 4, j = 4;
+
+    for (;;) {
+        SSE4_MERGE4(lo, hi);
+        _mm_storeu_si128((__m128i *)out, lo);
+        out += 4;
+
+        if (i < la && (j >= lb || a[i] <= b[j])) {
+            lo = _mm_loadu_si128((const __m128i *)(a + i));
+            i += 4;
+        } else if (j < lb) {
+            lo = _mm_loadu_si128((const __m128i *)(b + j));
+            j += 4;
+        } else {
+            break;
+        }
+    }
+    _mm_storeu_si128((__m128i *)out, hi);
+}
+
+#endif /* SIMD_SORT_X86 */
+
+/* ==================== ВЫБОР ЯДРА ==================== */
+
+static SortKernel select_kernel(void)
+{
+    if (active_kernel != KERNEL_UNKNOWN)
+        return active_kernel;
+
+    SortKernel kernel = KERNEL_SCALAR;
+#ifdef SIMD_SORT_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        kernel = KERNEL_AVX2;
+    else if (__builtin_cpu_supports("sse4.1"))
+        kernel = KERNEL_SSE4;
+#endif
+
+    // Явный выбор может только ослабить ядро, но не включить отсутствующее
+    const char *forced = getenv("QUEUE_SORT_KERNEL");
+    if (forced) {
+        if (strcmp(forced, "scalar") == 0)
+            kernel = KERNEL_SCALAR;
+        else if (strcmp(forced, "sse4") == 0 && kernel > KERNEL_SSE4)
+            kernel = KERNEL_SSE4;
+    }
+
+    active_kernel = kernel;
+    return kernel;
+}
+
+const char* simd_sort_kernel_name(void)
+{
+    switch (select_kernel()) {
+    case KERNEL_AVX2:
+        return "avx2";
+    case KERNEL_SSE4:
+        return "sse4";
+    default:
+        return "scalar";
+    }
+}
+
+void simd_sort_ints(int *a, size_t n)
+{
+    if (n < 2)
+        return;
+
+    SortKernel kernel = select_kernel();
+    if (kernel == KERNEL_SCALAR) {
+        scalar_sort(a, n);
+        return;
+    }
+
+    // Два буфера дополненной длины: блоки и проходы слияния идут между ними
+    size_t padded = (n + SIMD_PAD - 1) / SIMD_PAD * SIMD_PAD;
+    int *buf = (int *)malloc(2 * padded * sizeof(int));
+    if (!buf) {
+        scalar_sort(a, n);
+        return;
+    }
+
+    int *src = buf, *dst = buf + padded;
+    memcpy(src, a, n * sizeof(int));
+    for (size_t i = n; i < padded; i++)
+        src[i] = INT_MAX;
+
+    int *sorted = src;
+#ifdef SIMD_SORT_X86
+    if (kernel == KERNEL_AVX2) {
+        avx2_sort_blocks(src, padded);
+        sorted = merge_passes(src, dst, padded, 8, avx2_merge_runs);
+    } else {
+        sse4_sort_blocks(src, padded);
+        sorted = merge_passes(src, dst, padded, 4, sse4_merge_runs);
+    }
+#endif
+
+    memcpy(a, sorted, n * sizeof(int));
+    free(buf);
+}
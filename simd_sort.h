@@ -0,0 +1,19 @@
+#ifndef SIMD_SORT_H
+#define SIMD_SORT_H
+
+#include <stddef.h>
+
+//ВЕКТОРНАЯ СОРТИРОВКА МАССИВА int
+//Блоки по 8 (AVX2) или 4 (SSE4.1) значения сортируются сетью сравнений
+//внутри регистра, затем отсортированные отрезки сливаются векторным
+//битоническим слиянием. Набор инструкций выбирается один раз во время
+//работы по CPUID; без SSE4.1 используется обычная сортировка слиянием.
+//Переменная окружения QUEUE_SORT_KERNEL=avx2|sse4|scalar задает ядро явно.
+
+//Сортировка массива по возрастанию
+void simd_sort_ints(int *a, size_t n);
+
+//Название выбранного ядра ("avx2", "sse4", "scalar")
+const char* simd_sort_kernel_name(void);
+
+#endif /* SIMD_SORT_H */
@@ -0,0 +1,123 @@
+#include "sort_profile.h"
+#include <locale.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Виды хранилищ в профиле: list - список, array - ring и chunked
+static const char *kind_names[] = {"list", "array"};
+#define NUM_PROFILE_KINDS (int)(sizeof(kind_names) / sizeof(kind_names[0]))
+
+static QueueSortThresholds *tuning_kind(QueueSortTuning *tuning, int kind)
+{
+    return kind == 0 ? &tuning->list : &tuning->array;
+}
+
+// Дробная часть в файле всегда через точку, независимо от локали
+static void replace_char(char *s, char from, char to)
+{
+    for (; *s; s++) {
+        if (*s == from)
+            *s = to;
+    }
+}
+
+static int parse_size(const char *text, size_t *value)
+{
+    char *end;
+    if (text[0] == '-')
+        return -1;
+    unsigned long long v = strtoull(text, &end, 10);
+    if (end == text || *end != 0)
+        return -1;
+    *value = (size_t)v;
+    return 0;
+}
+
+static int parse_double(const char *text, double *value)
+{
+    char buf[64], *end;
+    snprintf(buf, sizeof(buf), "%s", text);
+    replace_char(buf, '.', localeconv()->decimal_point[0]);
+    *value = strtod(buf, &end);
+    return (end == buf || *end != 0) ? -1 : 0;
+}
+
+// Разбор строки "вид.порог=значение"; -1 - строка не разобрана
+// Неизвестные вид и порог пропускаются (профиль другой версии программы)
+static int parse_line(const char *line, QueueSortTuning *tuning)
+{
+    char kind[16], field[32], value[64];
+    if (sscanf(line, "%15[a-z_].%31[a-z_] = %63s", kind, field, value) != 3)
+        return -1;
+
+    QueueSortThresholds *th = NULL;
+    for (int k = 0; k < NUM_PROFILE_KINDS; k++) {
+        if (strcmp(kind, kind_names[k]) == 0)
+            th = tuning_kind(tuning, k);
+    }
+    if (!th)
+        return 0;
+
+    if (strcmp(field, "small_size") == 0)
+        return parse_size(value, &th->small_size);
+    if (strcmp(field, "run_ratio") == 0)
+        return parse_size(value, &th->run_ratio);
+    if (strcmp(field, "counting_ratio") == 0)
+        return parse_double(value, &th->counting_ratio);
+    if (strcmp(field, "parallel_size") == 0)
+        return parse_size(value, &th->parallel_size);
+    return 0;
+}
+
+int sort_profile_load(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return -1;
+
+    QueueSortTuning tuning;
+    queue_sort_tuning_get(&tuning);
+
+    char line[256];
+    int status = 0;
+    while (status == 0 && fgets(line, sizeof(line), f)) {
+        const char *p = line + strspn(line, " \t\r\n");
+        if (*p == 0 || *p == '#')
+            continue;
+        if (parse_line(p, &tuning) != 0)
+            status = -2;
+    }
+    fclose(f);
+
+    if (status == 0 && queue_sort_tuning_set(&tuning) != 0)
+        status = -2;
+    return status;
+}
+
+void sort_profile_write(FILE *stream, const QueueSortTuning *tuning)
+{
+    fprintf(stream, "# Пороги автовыбора сортировки (program --calibrate)\n");
+    for (int k = 0; k < NUM_PROFILE_KINDS; k++) {
+        const QueueSortThresholds *th = k == 0 ? &tuning->list : &tuning->array;
+        char ratio[32];
+        snprintf(ratio, sizeof(ratio), "%g", th->counting_ratio);
+        replace_char(ratio, localeconv()->decimal_point[0], '.');
+
+        fprintf(stream, "%s.small_size=%zu\n", kind_names[k], th->small_size);
+        fprintf(stream, "%s.run_ratio=%zu\n", kind_names[k], th->run_ratio);
+        fprintf(stream, "%s.counting_ratio=%s\n", kind_names[k], ratio);
+        fprintf(stream, "%s.parallel_size=%zu\n", kind_names[k], th->parallel_size);
+    }
+}
+
+int sort_profile_save(const char *path, const QueueSortTuning *tuning)
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+        return -1;
+    sort_profile_write(f, tuning);
+    int failed = ferror(f);
+    if (fclose(f) != 0)
+        failed = 1;
+    return failed ? -1 : 0;
+}
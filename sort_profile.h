@@ -0,0 +1,25 @@
+#ifndef SORT_PROFILE_H
+#define SORT_PROFILE_H
+
+#include <stdio.h>
+#include "queue.h"
+
+//ПРОФИЛЬ АВТОВЫБОРА СОРТИРОВКИ
+//Пороги queue_sort_auto, измеренные ключом --calibrate на текущей машине,
+//хранятся в текстовом файле строками "вид.порог=значение", например
+//"list.small_size=64"; строки с # - комментарии. Порог, которого нет
+//в файле, остается прежним. Файл читается при запуске программы.
+
+#define SORT_PROFILE_FILE "sort_profile.txt"
+
+//Чтение профиля и установка порогов: 0 - успех, -1 - файла нет,
+//-2 - файл поврежден (пороги не меняются)
+int sort_profile_load(const char *path);
+
+//Запись порогов в поток в формате профиля
+void sort_profile_write(FILE *stream, const QueueSortTuning *tuning);
+
+//Сохранение порогов в файл: 0 - успех, -1 - ошибка записи
+int sort_profile_save(const char *path, const QueueSortTuning *tuning);
+
+#endif /* SORT_PROFILE_H */
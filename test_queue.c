@@ -0,0 +1,185 @@
+#include "queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Регрессионные проверки очереди (make check)
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do {                     \
+    if (!(cond)) {                                \
+        printf("ОШИБКА %s:%d: ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__);                      \
+        printf("\n");                             \
+        failures++;                               \
+    }                                             \
+} while (0)
+
+// Индекс с шагом, не кратным степени двойки: после сдвига устаревших
+// записей base не должен уходить в минус, а узлы - в чужие записи
+static void check_index_stride(size_t stride)
+{
+    Queue q;
+    queue_init_backend(&q, QUEUE_BACKEND_LIST);
+    queue_enable_index(&q, stride);
+
+    int next = 0, first = 0, value;
+    for (; next < 6310; next++)
+        queue_push(&q, next);
+    queue_get_at(&q, 0, &value);
+    for (; first < 6301; first++)
+        queue_pop(&q, &value);
+    for (; next < 6700; next++)
+        queue_push(&q, next);
+
+    size_t errors = 0;
+    for (size_t i = 0; i < q.size; i++) {
+        if (queue_get_at(&q, i, &value) != 0 || value != first + (int)i)
+            errors++;
+    }
+    CHECK(errors == 0, "шаг индекса %zu: %zu неверных queue_get_at из %zu",
+          stride, errors, q.size);
+    queue_free(&q);
+}
+
+// Разорванный кольцевой буфер сортируется всеми способами
+static void check_ring_wrapped_sort(void)
+{
+    static const struct {
+        const char *name;
+        void (*sort)(Queue *q);
+    } sorts[] = {
+        {"selection", queue_selection_sort}, {"quick", queue_quick_sort},
+        {"merge", queue_merge_sort}, {"radix", queue_radix_sort},
+        {"adaptive", queue_adaptive_sort}, {"counting", queue_counting_sort},
+        {"simd", queue_simd_sort}, {"auto", queue_sort_auto},
+    };
+
+    for (size_t s = 0; s < sizeof(sorts) / sizeof(sorts[0]); s++) {
+        Queue q;
+        queue_init_backend(&q, QUEUE_BACKEND_RING);
+        int value;
+        srand(1);
+        for (int i = 0; i < 1000; i++)
+            queue_push(&q, rand() % 5000 - 2500);
+        for (int i = 0; i < 700; i++)
+            queue_pop(&q, &value);
+        for (int i = 0; i < 600; i++)
+            queue_push(&q, rand() % 5000 - 2500);
+
+        size_t size = q.size;
+        sorts[s].sort(&q);
+        CHECK(q.size == size && queue_is_sorted(&q),
+              "%s: разорванный кольцевой буфер не отсортирован", sorts[s].name);
+        queue_free(&q);
+    }
+}
+
+// Частичная сортировка разорванного кольцевого буфера: первые k -
+// k наименьших по возрастанию, остальные не меньше их
+static void check_ring_partial_sort(void)
+{
+    Queue q;
+    queue_init_backend(&q, QUEUE_BACKEND_RING);
+    int value;
+    srand(2);
+    for (int i = 0; i < 1000; i++)
+        queue_push(&q, rand() % 5000);
+    for (int i = 0; i < 700; i++)
+        queue_pop(&q, &value);
+    for (int i = 0; i < 600; i++)
+        queue_push(&q, rand() % 5000);
+
+    size_t k = 50;
+    int top[50];
+    queue_top_k(&q, k, top);
+    queue_partial_sort(&q, k);
+
+    size_t errors = 0;
+    for (size_t i = 0; i < q.size; i++) {
+        queue_get_at(&q, i, &value);
+        if (i < k ? value != top[i] : value < top[k - 1])
+            errors++;
+    }
+    CHECK(errors == 0, "частичная сортировка кольцевого буфера: %zu ошибок", errors);
+    queue_free(&q);
+}
+
+// Параллельная сортировка с повторами: равные значения расходятся
+// по диапазонам разных потоков, результат должен остаться упорядоченным
+static void check_parallel_duplicates(int distinct)
+{
+    Queue q;
+    queue_init_backend(&q, QUEUE_BACKEND_LIST);
+    srand(3);
+    for (int i = 0; i < 200000; i++)
+        queue_push(&q, rand() % distinct);
+
+    QueueParallelStats stats;
+    queue_parallel_sort_timed(&q, 4, &stats);
+    CHECK(q.size == 200000 && queue_is_sorted(&q),
+          "параллельная сортировка, %d различных значений: не упорядочено", distinct);
+    queue_free(&q);
+}
+
+// Последний элемент списка блоков после push, pop и пакетных операций
+static void check_chunked_back(void)
+{
+    Queue q;
+    queue_init_backend(&q, QUEUE_BACKEND_CHUNKED);
+    int values[300], popped[90], value, back;
+    for (int i = 0; i < 300; i++)
+        values[i] = i;
+
+    size_t errors = 0;
+    for (int round = 0; round < 20; round++) {
+        queue_push_n(&q, values, 100 + round * 7);
+        back = values[100 + round * 7 - 1];
+        queue_pop_n(&q, popped, 90);
+        if (queue_back(&q, &value) != 0 || value != back)
+            errors++;
+        queue_push(&q, -round);
+        if (queue_back(&q, &value) != 0 || value != -round)
+            errors++;
+    }
+    CHECK(errors == 0, "queue_back списка блоков: %zu ошибок", errors);
+    queue_free(&q);
+}
+
+// Быстрая сортировка списка на упорядоченных данных: раньше опорным был
+// последний узел, и такие входы шли за O(n²) с рекурсией глубины n
+static void check_list_quick_sort_sorted(void)
+{
+    for (int reversed = 0; reversed < 2; reversed++) {
+        Queue q;
+        queue_init_backend(&q, QUEUE_BACKEND_LIST);
+        for (int i = 0; i < 300000; i++)
+            queue_push(&q, reversed ? 300000 - i : i);
+        queue_quick_sort(&q);
+        CHECK(q.size == 300000 && queue_is_sorted(&q),
+              "быстрая сортировка списка (%s): не упорядочено",
+              reversed ? "по убыванию" : "по возрастанию");
+        queue_free(&q);
+    }
+}
+
+int main(void)
+{
+    check_index_stride(64);
+    check_index_stride(100);
+    check_index_stride(3);
+    check_chunked_back();
+    check_list_quick_sort_sorted();
+    check_ring_wrapped_sort();
+    check_ring_partial_sort();
+    check_parallel_duplicates(1);
+    check_parallel_duplicates(16);
+    check_parallel_duplicates(1000000);
+
+    if (failures) {
+        printf("Ошибок: %d\n", failures);
+        return 1;
+    }
+    printf("Все проверки пройдены\n");
+    return 0;
+}